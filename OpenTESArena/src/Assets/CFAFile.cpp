@@ -7,11 +7,15 @@
 #include "Compression.h"
 #include "../Utilities/Bytes.h"
 #include "../Utilities/Debug.h"
+#include "../Utilities/Kernels.h"
+#include "../Utilities/Profiler.h"
 
 #include "components/vfs/manager.hpp"
 
 CFAFile::CFAFile(const std::string &filename, const Palette &palette)
 {
+	Profiler::Zone zone("CFAFile");
+
 	VFS::IStreamPtr stream = VFS::Manager::get().open(filename.c_str());
 	Debug::check(stream != nullptr, "CFAFile", "Could not open \"" + filename + "\".");
 
@@ -145,6 +149,7 @@ CFAFile::CFAFile(const std::string &filename, const Palette &palette)
 	this->height = height;
 
 	// Finally, create 32-bit images using each frame's palette indices.
+	const PaletteARGB paletteColors = toPaletteARGB(palette);
 	for (const auto &frame : frames)
 	{
 		this->pixels.push_back(std::unique_ptr<uint32_t[]>(
@@ -152,11 +157,8 @@ CFAFile::CFAFile(const std::string &filename, const Palette &palette)
 
 		uint32_t *pixels = this->pixels.at(this->pixels.size() - 1).get();
 
-		std::transform(frame.begin(), frame.begin() + frame.size(), pixels,
-			[&palette](uint8_t col) -> uint32_t
-		{
-			return palette[col].toARGB();
-		});
+		Kernels::expandPalette(frame.data(), static_cast<int>(frame.size()),
+			paletteColors.data(), pixels);
 	}
 }
 
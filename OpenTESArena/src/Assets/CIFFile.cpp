@@ -1,4 +1,3 @@
-#include <algorithm>
 #include <unordered_map>
 
 #include "CIFFile.h"
@@ -6,6 +5,8 @@
 #include "Compression.h"
 #include "../Utilities/Bytes.h"
 #include "../Utilities/Debug.h"
+#include "../Utilities/Kernels.h"
+#include "../Utilities/Profiler.h"
 
 #include "components/vfs/manager.hpp"
 
@@ -27,6 +28,8 @@ namespace
 CIFFile::CIFFile(const std::string &filename, const Palette &palette)
 	: pixels(), offsets(), dimensions()
 {
+	Profiler::Zone zone("CIFFile");
+
 	VFS::IStreamPtr stream = VFS::Manager::get().open(filename.c_str());
 	Debug::check(stream != nullptr, "CIFFile", "Could not open \"" + filename + "\".");
 
@@ -37,6 +40,8 @@ CIFFile::CIFFile(const std::string &filename, const Palette &palette)
 	std::vector<uint8_t> srcData(fileSize);
 	stream->read(reinterpret_cast<char*>(srcData.data()), srcData.size());
 
+	const PaletteARGB paletteColors = toPaletteARGB(palette);
+
 	// X and Y offset might be useful for weapon positions on the screen.
 	uint16_t xoff, yoff, width, height, flags, len;
 
@@ -92,11 +97,8 @@ CIFFile::CIFFile(const std::string &filename, const Palette &palette)
 			const uint8_t *imagePixels = decomp.data();
 			uint32_t *dstPixels = this->pixels.at(this->pixels.size() - 1).get();
 
-			std::transform(imagePixels, imagePixels + (width * height), dstPixels,
-				[&palette](uint8_t col) -> uint32_t
-			{
-				return palette[col].toARGB();
-			});
+			Kernels::expandPalette(imagePixels, width * height,
+				paletteColors.data(), dstPixels);
 
 			offset += (headerSize + len);
 		}
@@ -126,11 +128,8 @@ CIFFile::CIFFile(const std::string &filename, const Palette &palette)
 			const uint8_t *imagePixels = decomp.data();
 			uint32_t *dstPixels = this->pixels.at(this->pixels.size() - 1).get();
 
-			std::transform(imagePixels, imagePixels + (width * height), dstPixels,
-				[&palette](uint8_t col) -> uint32_t
-			{
-				return palette[col].toARGB();
-			});
+			Kernels::expandPalette(imagePixels, width * height,
+				paletteColors.data(), dstPixels);
 
 			offset += (headerSize + len);
 		}
@@ -163,11 +162,8 @@ CIFFile::CIFFile(const std::string &filename, const Palette &palette)
 			const uint8_t *imagePixels = decomp.data();
 			uint32_t *dstPixels = this->pixels.at(this->pixels.size() - 1).get();
 
-			std::transform(imagePixels, imagePixels + (width * height), dstPixels,
-				[&palette](uint8_t col) -> uint32_t
-			{
-				return palette[col].toARGB();
-			});
+			Kernels::expandPalette(imagePixels, width * height,
+				paletteColors.data(), dstPixels);
 
 			offset += (headerSize + len);
 		}
@@ -186,11 +182,7 @@ CIFFile::CIFFile(const std::string &filename, const Palette &palette)
 			const uint8_t *imagePixels = srcData.data() + (len * i);
 			uint32_t *dstPixels = this->pixels.at(this->pixels.size() - 1).get();
 
-			std::transform(imagePixels, imagePixels + len, dstPixels,
-				[&palette](uint8_t col) -> uint32_t
-			{
-				return palette[col].toARGB();
-			});
+			Kernels::expandPalette(imagePixels, len, paletteColors.data(), dstPixels);
 		}
 	}
 	else if ((flags & 0x00FF) == 0)
@@ -216,11 +208,7 @@ CIFFile::CIFFile(const std::string &filename, const Palette &palette)
 			const uint8_t *imagePixels = header + headerSize;
 			uint32_t *dstPixels = this->pixels.at(this->pixels.size() - 1).get();
 
-			std::transform(imagePixels, imagePixels + len, dstPixels,
-				[&palette](uint8_t col) -> uint32_t
-			{
-				return palette[col].toARGB();
-			});
+			Kernels::expandPalette(imagePixels, len, paletteColors.data(), dstPixels);
 
 			// Skip to the next image header.
 			offset += (headerSize + len);
@@ -5,12 +5,15 @@
 
 #include "../Utilities/Bytes.h"
 #include "../Utilities/Debug.h"
+#include "../Utilities/Profiler.h"
 #include "../Utilities/String.h"
 
 #include "components/vfs/manager.hpp"
 
 void COLFile::toPalette(const std::string &filename, Palette &dstPalette)
 {
+	Profiler::Zone zone("COLFile::toPalette");
+
 	bool failed = false;
 	std::array<uint8_t, 776> rawpal;
 	VFS::IStreamPtr stream = VFS::Manager::get().open(filename.c_str());
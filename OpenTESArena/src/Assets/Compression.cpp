@@ -3,39 +3,44 @@
 void Compression::decodeRLE(const uint8_t *src, uint32_t stopCount, 
 	std::vector<uint8_t> &out)
 {
-	// Adapted from WinArena.
-	uint32_t i = 0;
+	Profiler::Zone zone("Compression::decodeRLE");
+
+	// Adapted from WinArena. Each packet is checked against the end of the output
+	// once, and then written as a whole run with std::fill() or std::copy(), which
+	// become memset() and memcpy() (the C library picks their SIMD variant for the
+	// CPU). Packets themselves have to be read one after another, since each one's
+	// position depends on the lengths of the ones before it.
+	const uint32_t outSize = static_cast<uint32_t>(out.size());
 	uint32_t o = 0;
 
 	while (o < stopCount)
 	{
-		const uint8_t sample = src[i];
+		const uint8_t sample = *src;
 		src++;
 
 		// Is the selected byte part of a compressed packet?
-		if ((sample & 0x80) != 0)
+		const bool isRun = (sample & 0x80) != 0;
+		const uint32_t count = isRun ? (static_cast<uint32_t>(sample) - 0x7F) :
+			(static_cast<uint32_t>(sample) + 1);
+
+		if (count > (outSize - o))
 		{
-			const uint8_t value = src[i];
-			src++;
+			throw std::runtime_error("Decoded image overflow.");
+		}
 
-			const uint32_t count = static_cast<uint32_t>(sample) - 0x7F;
+		if (isRun)
+		{
+			const uint8_t value = *src;
+			src++;
 
-			for (uint32_t j = 0; j < count; ++j)
-			{
-				out.at(o) = value;
-				o++;
-			}
+			std::fill(out.begin() + o, out.begin() + o + count, value);
 		}
 		else
 		{
-			const uint32_t count = static_cast<uint32_t>(sample) + 1;
-
-			for (uint32_t j = 0; j < count; ++j)
-			{
-				out.at(o) = src[i];
-				o++;
-				i++;
-			}
+			std::copy(src, src + count, out.begin() + o);
+			src += count;
 		}
+
+		o += count;
 	}
 }
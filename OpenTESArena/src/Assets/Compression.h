@@ -5,9 +5,11 @@
 #include <array>
 #include <cstdint>
 #include <numeric>
+#include <stdexcept>
 #include <vector>
 
 #include "../Utilities/Debug.h"
+#include "../Utilities/Profiler.h"
 
 // There are a few different methods used for compressing textures in Arena.
 // The reusable decompression algorithms will be kept in this class.
@@ -26,6 +28,8 @@ public:
 	template <typename T>
 	static void decodeType04(T src, T srcend, std::vector<uint8_t> &out)
 	{
+		Profiler::Zone zone("Compression::decodeType04");
+
 		auto dst = out.begin();
 
 		std::array<uint8_t, 4096> history;
@@ -99,6 +103,8 @@ public:
 	template <typename T>
 	static void decodeType08(T src, T srcend, std::vector<uint8_t> &out)
 	{
+		Profiler::Zone zone("Compression::decodeType08");
+
 		static const std::array<uint8_t, 256> highOffsetBits{
 			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
 			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
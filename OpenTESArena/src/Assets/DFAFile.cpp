@@ -1,16 +1,18 @@
-#include <algorithm>
-
 #include "DFAFile.h"
 
 #include "Compression.h"
 #include "../Utilities/Bytes.h"
 #include "../Utilities/Debug.h"
+#include "../Utilities/Kernels.h"
+#include "../Utilities/Profiler.h"
 
 #include "components/vfs/manager.hpp"
 
 DFAFile::DFAFile(const std::string &filename, const Palette &palette)
 	: pixels()
 {
+	Profiler::Zone zone("DFAFile");
+
 	VFS::IStreamPtr stream = VFS::Manager::get().open(filename.c_str());
 	Debug::check(stream != nullptr, "DFAFile", "Could not open \"" + filename + "\".");
 
@@ -82,6 +84,7 @@ DFAFile::DFAFile(const std::string &filename, const Palette &palette)
 	this->height = height;
 
 	// Finally, create 32-bit images using each frame's palette indices.
+	const PaletteARGB paletteColors = toPaletteARGB(palette);
 	for (const auto &frame : frames)
 	{
 		this->pixels.push_back(std::unique_ptr<uint32_t[]>(
@@ -89,11 +92,8 @@ DFAFile::DFAFile(const std::string &filename, const Palette &palette)
 
 		uint32_t *dstPixels = this->pixels.at(this->pixels.size() - 1).get();
 
-		std::transform(frame.begin(), frame.begin() + frame.size(), dstPixels,
-			[&palette](uint8_t col) -> uint32_t
-		{
-			return palette[col].toARGB();
-		});
+		Kernels::expandPalette(frame.data(), static_cast<int>(frame.size()),
+			paletteColors.data(), dstPixels);
 	}
 }
 
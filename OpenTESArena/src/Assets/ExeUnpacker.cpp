@@ -8,6 +8,7 @@
 
 #include "../Utilities/Bytes.h"
 #include "../Utilities/Debug.h"
+#include "../Utilities/Profiler.h"
 #include "../Utilities/String.h"
 
 #include "components/vfs/manager.hpp"
@@ -190,6 +191,8 @@ namespace
 
 ExeUnpacker::ExeUnpacker(const std::string &filename)
 {
+	Profiler::Zone zone("ExeUnpacker");
+
 	Debug::mention("Exe Unpacker", "Unpacking \"" + filename + "\".");
 
 	VFS::IStreamPtr stream = VFS::Manager::get().open(filename.c_str());
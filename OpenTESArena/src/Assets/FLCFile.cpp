@@ -1,4 +1,3 @@
-#include <algorithm>
 #include <array>
 
 #include "FLCFile.h"
@@ -6,6 +5,8 @@
 #include "Compression.h"
 #include "../Utilities/Bytes.h"
 #include "../Utilities/Debug.h"
+#include "../Utilities/Kernels.h"
+#include "../Utilities/Profiler.h"
 #include "../Utilities/String.h"
 
 #include "components/vfs/manager.hpp"
@@ -91,6 +92,8 @@ struct ChunkHeader
 
 FLCFile::FLCFile(const std::string &filename)
 {
+	Profiler::Zone zone("FLCFile");
+
 	VFS::IStreamPtr stream = VFS::Manager::get().open(filename.c_str());
 	Debug::check(stream != nullptr, "FLCFile", "Could not open \"" + filename + "\".");
 
@@ -233,6 +236,8 @@ void FLCFile::readPaletteData(const uint8_t *chunkData, Palette &dstPalette)
 std::unique_ptr<uint32_t[]> FLCFile::decodeFullFrame(const uint8_t *chunkData,
 	int chunkSize, const Palette &palette, std::vector<uint8_t> &initialFrame)
 {
+	Profiler::Zone zone("FLCFile::decodeFullFrame");
+
 	// Decode a fullscreen image chunk. Most likely the first image in the FLIC.
 	std::vector<uint8_t> decomp(this->width * this->height);
 
@@ -294,14 +299,13 @@ std::unique_ptr<uint32_t[]> FLCFile::decodeFullFrame(const uint8_t *chunkData,
 	// Write the decoded frame to the initial (scratch) frame.
 	initialFrame = decomp;
 
+	// The palette can change between frames, so its colors are gotten each time.
+	const PaletteARGB paletteColors = toPaletteARGB(palette);
 	const uint8_t *decompPixels = decomp.data();
 	std::unique_ptr<uint32_t[]> image(new uint32_t[this->width * this->height]);
 
-	std::transform(decompPixels, decompPixels + decomp.size(), image.get(),
-		[&palette](uint8_t col) -> uint32_t
-	{
-		return palette[col].toARGB();
-	});
+	Kernels::expandPalette(decompPixels, static_cast<int>(decomp.size()),
+		paletteColors.data(), image.get());
 
 	return std::move(image);
 }
@@ -309,6 +313,8 @@ std::unique_ptr<uint32_t[]> FLCFile::decodeFullFrame(const uint8_t *chunkData,
 std::unique_ptr<uint32_t[]> FLCFile::decodeDeltaFrame(const uint8_t *chunkData,
 	int chunkSize, const Palette &palette, std::vector<uint8_t> &initialFrame)
 {
+	Profiler::Zone zone("FLCFile::decodeDeltaFrame");
+
 	// Decode a delta frame chunk. The majority of FLIC frames are this format.
 
 	// The line count is the number of rows with encoded packets.
@@ -430,14 +436,12 @@ std::unique_ptr<uint32_t[]> FLCFile::decodeDeltaFrame(const uint8_t *chunkData,
 
 	// Use the modified initial frame as the source instead of a separate
 	// decompressed buffer.
+	const PaletteARGB paletteColors = toPaletteARGB(palette);
 	const uint8_t *framePixels = initialFrame.data();
 	std::unique_ptr<uint32_t[]> image(new uint32_t[this->width * this->height]);
 
-	std::transform(framePixels, framePixels + initialFrame.size(), image.get(),
-		[&palette](uint8_t col) -> uint32_t
-	{
-		return palette[col].toARGB();
-	});
+	Kernels::expandPalette(framePixels, static_cast<int>(initialFrame.size()),
+		paletteColors.data(), image.get());
 
 	return std::move(image);
 }
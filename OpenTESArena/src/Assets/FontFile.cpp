@@ -8,6 +8,7 @@
 #include "../Media/Font.h"
 #include "../Media/FontName.h"
 #include "../Utilities/Debug.h"
+#include "../Utilities/Profiler.h"
 
 #include "components/vfs/manager.hpp"
 
@@ -44,6 +45,8 @@ namespace
 FontFile::FontFile(const std::string &filename)
 	: characters()
 {
+	Profiler::Zone zone("FontFile");
+
 	VFS::IStreamPtr stream = VFS::Manager::get().open(filename.c_str());
 	Debug::check(stream != nullptr, "Font File", "Could not open \"" + filename + "\".");
 
@@ -6,6 +6,8 @@
 #include "../Math/Vector2.h"
 #include "../Utilities/Bytes.h"
 #include "../Utilities/Debug.h"
+#include "../Utilities/Kernels.h"
+#include "../Utilities/Profiler.h"
 
 #include "components/vfs/manager.hpp"
 
@@ -34,6 +36,8 @@ namespace
 
 IMGFile::IMGFile(const std::string &filename, const Palette *palette)
 {
+	Profiler::Zone zone("IMGFile");
+
 	VFS::IStreamPtr stream = VFS::Manager::get().open(filename.c_str());
 	Debug::check(stream != nullptr, "IMGFile", "Could not open \"" + filename + "\".");
 
@@ -99,20 +103,18 @@ IMGFile::IMGFile(const std::string &filename, const Palette *palette)
 	}
 
 	// Choose which palette to use.
-	const Palette &paletteRef = useBuiltInPalette ? builtInPalette : (*palette);
+	const PaletteARGB paletteColors = toPaletteARGB(
+		useBuiltInPalette ? builtInPalette : (*palette));
 
 	// Lambda for setting IMGFile members and constructing the final image.
-	auto makeImage = [this, &paletteRef](int width, int height, const uint8_t *data)
+	auto makeImage = [this, &paletteColors](int width, int height, const uint8_t *data)
 	{
 		this->width = width;
 		this->height = height;
 		this->pixels = std::unique_ptr<uint32_t[]>(new uint32_t[width * height]);
 
-		std::transform(data, data + (width * height), this->pixels.get(),
-			[&paletteRef](uint8_t col) -> uint32_t
-		{
-			return paletteRef[col].toARGB();
-		});
+		Kernels::expandPalette(data, width * height,
+			paletteColors.data(), this->pixels.get());
 	};
 
 	// Decide how to use the pixel data.
@@ -192,6 +194,8 @@ void IMGFile::readPalette(const uint8_t *paletteData, Palette &dstPalette)
 
 void IMGFile::extractPalette(const std::string &filename, Palette &dstPalette)
 {
+	Profiler::Zone zone("IMGFile::extractPalette");
+
 	VFS::IStreamPtr stream = VFS::Manager::get().open(filename.c_str());
 	Debug::check(stream != nullptr, "IMGFile", "Could not open \"" + filename + "\".");
 
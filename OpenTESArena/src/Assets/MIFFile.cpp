@@ -2,11 +2,14 @@
 
 #include "../Utilities/Bytes.h"
 #include "../Utilities/Debug.h"
+#include "../Utilities/Profiler.h"
 
 #include "components/vfs/manager.hpp"
 
 MIFFile::MIFFile(const std::string &filename)
 {
+	Profiler::Zone zone("MIFFile");
+
 	VFS::IStreamPtr stream = VFS::Manager::get().open(filename.c_str());
 	Debug::check(stream != nullptr, "MIFFile", "Could not open \"" + filename + "\".");
 
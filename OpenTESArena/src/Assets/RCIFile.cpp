@@ -1,8 +1,8 @@
-#include <algorithm>
-
 #include "RCIFile.h"
 
 #include "../Utilities/Debug.h"
+#include "../Utilities/Kernels.h"
+#include "../Utilities/Profiler.h"
 
 #include "components/vfs/manager.hpp"
 
@@ -12,6 +12,8 @@ const int RCIFile::FRAME_SIZE = RCIFile::FRAME_WIDTH * RCIFile::FRAME_HEIGHT;
 
 RCIFile::RCIFile(const std::string &filename, const Palette &palette)
 {
+	Profiler::Zone zone("RCIFile");
+
 	VFS::IStreamPtr stream = VFS::Manager::get().open(filename.c_str());
 	Debug::check(stream != nullptr, "RCIFile", "Could not open \"" + filename + "\".");
 
@@ -26,6 +28,7 @@ RCIFile::RCIFile(const std::string &filename, const Palette &palette)
 	const int frameCount = static_cast<int>(fileSize) / RCIFile::FRAME_SIZE;
 
 	// Create an image for each uncompressed frame using the given palette.
+	const PaletteARGB paletteColors = toPaletteARGB(palette);
 	for (int frameIndex = 0; frameIndex < frameCount; ++frameIndex)
 	{
 		this->frames.push_back(std::unique_ptr<uint32_t[]>(
@@ -33,13 +36,8 @@ RCIFile::RCIFile(const std::string &filename, const Palette &palette)
 
 		const int byteOffset = RCIFile::FRAME_SIZE * frameIndex;
 
-		std::transform(srcData.begin() + byteOffset,
-			srcData.begin() + byteOffset + RCIFile::FRAME_SIZE,
-			this->frames.at(frameIndex).get(),
-			[&palette](uint8_t col) -> uint32_t
-		{
-			return palette[col].toARGB();
-		});
+		Kernels::expandPalette(srcData.data() + byteOffset, RCIFile::FRAME_SIZE,
+			paletteColors.data(), this->frames.at(frameIndex).get());
 	}
 }
 
@@ -1,8 +1,8 @@
-#include <algorithm>
-
 #include "SETFile.h"
 
 #include "../Utilities/Debug.h"
+#include "../Utilities/Kernels.h"
+#include "../Utilities/Profiler.h"
 
 #include "components/vfs/manager.hpp"
 
@@ -12,6 +12,8 @@ const int SETFile::CHUNK_SIZE = SETFile::CHUNK_WIDTH * SETFile::CHUNK_HEIGHT;
 
 SETFile::SETFile(const std::string &filename, const Palette &palette)
 {
+	Profiler::Zone zone("SETFile");
+
 	VFS::IStreamPtr stream = VFS::Manager::get().open(filename.c_str());
 	Debug::check(stream != nullptr, "SETFile", "Could not open \"" + filename + "\".");
 
@@ -26,6 +28,7 @@ SETFile::SETFile(const std::string &filename, const Palette &palette)
 	const int chunkCount = static_cast<int>(fileSize) / SETFile::CHUNK_SIZE;
 
 	// Create an image for each uncompressed chunk using the given palette.
+	const PaletteARGB paletteColors = toPaletteARGB(palette);
 	for (int chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex)
 	{
 		this->chunks.push_back(std::unique_ptr<uint32_t[]>(
@@ -33,13 +36,8 @@ SETFile::SETFile(const std::string &filename, const Palette &palette)
 
 		const int byteOffset = SETFile::CHUNK_SIZE * chunkIndex;
 
-		std::transform(srcData.begin() + byteOffset,
-			srcData.begin() + byteOffset + SETFile::CHUNK_SIZE,
-			this->chunks.at(chunkIndex).get(),
-			[&palette](uint8_t col) -> uint32_t
-		{
-			return palette[col].toARGB();
-		});
+		Kernels::expandPalette(srcData.data() + byteOffset, SETFile::CHUNK_SIZE,
+			paletteColors.data(), this->chunks.at(chunkIndex).get());
 	}
 }
 
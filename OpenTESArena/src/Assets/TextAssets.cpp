@@ -5,6 +5,7 @@
 #include "TextAssets.h"
 
 #include "../Utilities/Debug.h"
+#include "../Utilities/Profiler.h"
 #include "../Utilities/String.h"
 
 #include "components/vfs/manager.hpp"
@@ -23,6 +24,8 @@ TextAssets::~TextAssets()
 
 void TextAssets::parseTemplateDat()
 {
+	Profiler::Zone zone("TextAssets::parseTemplateDat");
+
 	const std::string filename = "TEMPLATE.DAT";
 
 	VFS::IStreamPtr stream = VFS::Manager::get().open(filename.c_str());
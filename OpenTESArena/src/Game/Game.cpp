@@ -22,7 +22,10 @@
 #include "../Media/TextureName.h"
 #include "../Rendering/Renderer.h"
 #include "../Rendering/Surface.h"
+#include "../Utilities/CPUFeatures.h"
 #include "../Utilities/Debug.h"
+#include "../Utilities/FrameTimings.h"
+#include "../Utilities/Profiler.h"
 
 #include "components/vfs/manager.hpp"
 
@@ -34,6 +37,25 @@ Game::Game()
 	// Load options from file.
 	this->options = OptionsParser::parse();
 
+	// Record profiler zones if there's somewhere to write them.
+	Profiler::setThreadName("Main");
+	Profiler::setEnabled(this->options->getTraceFile().size() > 0);
+
+	// Use the CPU's best SIMD tier unless another one is given.
+	const std::string &tierName = this->options->getCPUFeatureTier();
+	CPUFeatures::Tier tier;
+	if (CPUFeatures::tryParseTier(tierName, tier))
+	{
+		CPUFeatures::setTier(tier);
+	}
+	else if (tierName != "Auto")
+	{
+		Debug::mention("Game", "Unrecognized CPU feature tier \"" + tierName + "\".");
+	}
+
+	Debug::mention("Game", "Using " +
+		std::string(CPUFeatures::getTierName(CPUFeatures::getTier())) + " CPU features.");
+
 	// Initialize virtual file system using the Arena path in the options file.
 	VFS::Manager::get().initialize(std::string(this->options->getArenaPath()));
 
@@ -45,6 +67,9 @@ Game::Game()
 		this->options->getScreenWidth(), this->options->getScreenHeight(),
 		this->options->isFullscreen(), this->options->getLetterboxAspect()));
 
+	// Write frame timings to a file if requested.
+	this->renderer->getFrameTimings().setCSVPath(this->options->getFrameTimingsFile());
+
 	// Initialize the texture manager with the SDL window's pixel format.
 	this->textureManager = std::unique_ptr<TextureManager>(new TextureManager(
 		*this->renderer.get()));
@@ -144,6 +169,7 @@ void Game::setGameData(std::unique_ptr<GameData> gameData)
 
 void Game::delay(int ms)
 {
+	Profiler::Zone zone("Game::delay");
 	assert(ms >= 0);
 	SDL_Delay(static_cast<uint32_t>(ms));
 }
@@ -156,6 +182,8 @@ void Game::resizeWindow(int width, int height)
 
 void Game::handleEvents(bool &running)
 {
+	Profiler::Zone zone("Game::handleEvents");
+
 	// Handle events for the current game state.
 	SDL_Event e;
 	while (SDL_PollEvent(&e) != 0)
@@ -166,6 +194,8 @@ void Game::handleEvents(bool &running)
 			(e.window.event == SDL_WINDOWEVENT_RESIZED);
 		bool takeScreenshot = (e.type == SDL_KEYDOWN) &&
 			(e.key.keysym.sym == SDLK_PRINTSCREEN);
+		bool writeTrace = (e.type == SDL_KEYDOWN) &&
+			(e.key.keysym.sym == SDLK_F4) && Profiler::isEnabled();
 
 		if (applicationExit)
 		{
@@ -187,6 +217,12 @@ void Game::handleEvents(bool &running)
 			SDL_SaveBMP(screenshot.get(), "out.bmp");
 		}
 
+		if (writeTrace)
+		{
+			// Save the most recent profiler zones, i.e., right after a stall.
+			Profiler::writeTrace(this->options->getTraceFile());
+		}
+
 		// Panel-specific events are handled by the panel.
 		this->panel->handleEvent(e);
 
@@ -201,8 +237,13 @@ void Game::handleEvents(bool &running)
 
 void Game::tick(double dt)
 {
+	Profiler::Zone zone("Game::tick");
+
 	// Tick the current panel by delta time.
-	this->panel->tick(dt);
+	{
+		FrameTimings::Scope timingScope(this->renderer->getFrameTimings(), "Tick");
+		this->panel->tick(dt);
+	}
 
 	// If the panel tick requested a new panel, switch to it.
 	if (this->nextPanel.get() != nullptr)
@@ -213,8 +254,10 @@ void Game::tick(double dt)
 
 void Game::render()
 {
+	Profiler::Zone zone("Game::render");
 	this->panel->render(*this->renderer.get());
 	this->renderer->present();
+	this->renderer->getFrameTimings().endFrame();
 }
 
 void Game::loop()
@@ -229,6 +272,8 @@ void Game::loop()
 	bool running = true;
 	while (running)
 	{
+		Profiler::Zone zone("Game::loop");
+
 		lastTime = thisTime;
 		thisTime = SDL_GetTicks();
 
@@ -256,4 +301,9 @@ void Game::loop()
 		// Draw to the screen.
 		this->render();
 	}
+
+	if (Profiler::isEnabled())
+	{
+		Profiler::writeTrace(this->options->getTraceFile());
+	}
 }
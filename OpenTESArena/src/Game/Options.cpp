@@ -8,9 +8,15 @@ const int Options::MIN_FPS = 15;
 
 Options::Options(std::string &&dataPath, int screenWidth, int screenHeight, bool fullscreen,
 	int targetFPS, double resolutionScale, double verticalFOV, double letterboxAspect,
-	double cursorScale, double hSensitivity, double vSensitivity, std::string &&soundfont,
-	double musicVolume, double soundVolume, int soundChannels, bool skipIntro)
-	: arenaPath(std::move(dataPath)), soundfont(std::move(soundfont))
+	double cursorScale, int renderThreadCount, bool pinRenderThreads,
+	bool pipelinedRendering, bool full3DRendering, bool tiled3DRendering,
+	bool palettedRendering, double hSensitivity, double vSensitivity, std::string &&soundfont,
+	double musicVolume, double soundVolume, int soundChannels, bool skipIntro,
+	bool showFrameTimings, std::string &&frameTimingsFile, std::string &&traceFile,
+	std::string &&cpuFeatureTier)
+	: arenaPath(std::move(dataPath)), soundfont(std::move(soundfont)),
+	frameTimingsFile(std::move(frameTimingsFile)), traceFile(std::move(traceFile)),
+	cpuFeatureTier(std::move(cpuFeatureTier))
 {
 	// Make sure each of the values is in a valid range.
 	Debug::check(screenWidth > 0, "Options", "Screen width must be positive.");
@@ -22,6 +28,7 @@ Options::Options(std::string &&dataPath, int screenWidth, int screenHeight, bool
 		"Field of view must be between 0.0 and 180.0 exclusive.");
 	Debug::check(letterboxAspect > 0.0, "Options", "Letterbox aspect must be positive.");
 	Debug::check(cursorScale > 0.0, "Options", "Cursor scale must be positive.");
+	Debug::check(renderThreadCount >= 0, "Options", "Render thread count must not be negative.");
 	Debug::check(hSensitivity > 0.0, "Options", "Horizontal sensitivity must be positive.");
 	Debug::check(vSensitivity > 0.0, "Options", "Vertical sensitivity must be positive.");
 	Debug::check((musicVolume >= 0.0) && (musicVolume <= 1.0), "Options",
@@ -38,12 +45,19 @@ Options::Options(std::string &&dataPath, int screenWidth, int screenHeight, bool
 	this->verticalFOV = verticalFOV;
 	this->letterboxAspect = letterboxAspect;
 	this->cursorScale = cursorScale;
+	this->renderThreadCount = renderThreadCount;
+	this->pinRenderThreads = pinRenderThreads;
+	this->pipelinedRendering = pipelinedRendering;
+	this->full3DRendering = full3DRendering;
+	this->tiled3DRendering = tiled3DRendering;
+	this->palettedRendering = palettedRendering;
 	this->hSensitivity = hSensitivity;
 	this->vSensitivity = vSensitivity;
 	this->musicVolume = musicVolume;
 	this->soundVolume = soundVolume;
 	this->soundChannels = soundChannels;
 	this->skipIntro = skipIntro;
+	this->showFrameTimings = showFrameTimings;
 }
 
 Options::~Options()
@@ -91,6 +105,36 @@ double Options::getCursorScale() const
 	return this->cursorScale;
 }
 
+int Options::getRenderThreadCount() const
+{
+	return this->renderThreadCount;
+}
+
+bool Options::renderThreadsArePinned() const
+{
+	return this->pinRenderThreads;
+}
+
+bool Options::renderingIsPipelined() const
+{
+	return this->pipelinedRendering;
+}
+
+bool Options::renderingIsFull3D() const
+{
+	return this->full3DRendering;
+}
+
+bool Options::renderingIsTiled3D() const
+{
+	return this->tiled3DRendering;
+}
+
+bool Options::renderingIsPaletted() const
+{
+	return this->palettedRendering;
+}
+
 double Options::getHorizontalSensitivity() const
 {
 	return this->hSensitivity;
@@ -131,6 +175,26 @@ bool Options::introIsSkipped() const
 	return this->skipIntro;
 }
 
+bool Options::frameTimingsAreShown() const
+{
+	return this->showFrameTimings;
+}
+
+const std::string &Options::getFrameTimingsFile() const
+{
+	return this->frameTimingsFile;
+}
+
+const std::string &Options::getTraceFile() const
+{
+	return this->traceFile;
+}
+
+const std::string &Options::getCPUFeatureTier() const
+{
+	return this->cpuFeatureTier;
+}
+
 void Options::setScreenWidth(int width)
 {
 	assert(width > 0);
@@ -180,6 +244,38 @@ void Options::setCursorScale(double cursorScale)
 	this->cursorScale = cursorScale;
 }
 
+void Options::setRenderThreadCount(int count)
+{
+	assert(count >= 0);
+
+	this->renderThreadCount = count;
+}
+
+void Options::setPinRenderThreads(bool pin)
+{
+	this->pinRenderThreads = pin;
+}
+
+void Options::setPipelinedRendering(bool pipelined)
+{
+	this->pipelinedRendering = pipelined;
+}
+
+void Options::setFull3DRendering(bool full3D)
+{
+	this->full3DRendering = full3D;
+}
+
+void Options::setTiled3DRendering(bool tiled3D)
+{
+	this->tiled3DRendering = tiled3D;
+}
+
+void Options::setPalettedRendering(bool paletted)
+{
+	this->palettedRendering = paletted;
+}
+
 void Options::setHorizontalSensitivity(double hSensitivity)
 {
 	this->hSensitivity = hSensitivity;
@@ -225,3 +321,23 @@ void Options::setSkipIntro(bool skip)
 {
 	this->skipIntro = skip;
 }
+
+void Options::setShowFrameTimings(bool show)
+{
+	this->showFrameTimings = show;
+}
+
+void Options::setFrameTimingsFile(std::string file)
+{
+	this->frameTimingsFile = std::move(file);
+}
+
+void Options::setTraceFile(std::string file)
+{
+	this->traceFile = std::move(file);
+}
+
+void Options::setCPUFeatureTier(std::string tier)
+{
+	this->cpuFeatureTier = std::move(tier);
+}
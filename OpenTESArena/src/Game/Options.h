@@ -17,6 +17,12 @@ private:
 	double verticalFOV; // In degrees.
 	double letterboxAspect;
 	double cursorScale;
+	int renderThreadCount; // Zero for one thread per hardware thread.
+	bool pinRenderThreads;
+	bool pipelinedRendering; // Adds one frame of latency (the only amount supported).
+	bool full3DRendering; // Ray casts every pixel instead of every column.
+	bool tiled3DRendering; // Renders full 3D in square tiles instead of columns.
+	bool palettedRendering; // Renders 2.5D as palette indices, converted at the end.
 
 	// Input.
 	double hSensitivity, vSensitivity;
@@ -29,11 +35,19 @@ private:
 	// Miscellaneous.
 	std::string arenaPath; // "ARENA" data path.
 	bool skipIntro;
+	bool showFrameTimings; // Shows frame timings over the game world.
+	std::string frameTimingsFile; // CSV file for frame timings. Empty if unused.
+	std::string traceFile; // Trace file for the profiler. Empty if unused.
+	std::string cpuFeatureTier; // SIMD tier to use, or "Auto" to detect it.
 public:
 	Options(std::string &&arenaPath, int screenWidth, int screenHeight, bool fullscreen,
 		int targetFPS, double resolutionScale, double verticalFOV, double letterboxAspect, 
-		double cursorScale, double hSensitivity, double vSensitivity, std::string &&soundfont, 
-		double musicVolume, double soundVolume, int soundChannels, bool skipIntro);
+		double cursorScale, int renderThreadCount, bool pinRenderThreads,
+		bool pipelinedRendering, bool full3DRendering, bool tiled3DRendering,
+		bool palettedRendering, double hSensitivity, double vSensitivity, std::string &&soundfont,
+		double musicVolume, double soundVolume, int soundChannels, bool skipIntro,
+		bool showFrameTimings, std::string &&frameTimingsFile, std::string &&traceFile,
+		std::string &&cpuFeatureTier);
 	~Options();
 
 	static const int MIN_FPS;
@@ -46,6 +60,12 @@ public:
 	double getVerticalFOV() const;
 	double getLetterboxAspect() const;
 	double getCursorScale() const;
+	int getRenderThreadCount() const;
+	bool renderThreadsArePinned() const;
+	bool renderingIsPipelined() const;
+	bool renderingIsFull3D() const;
+	bool renderingIsTiled3D() const;
+	bool renderingIsPaletted() const;
 	double getHorizontalSensitivity() const;
 	double getVerticalSensitivity() const;
 	const std::string &getSoundfont() const;
@@ -54,6 +74,10 @@ public:
 	int getSoundChannelCount() const;
 	const std::string &getArenaPath() const;
 	bool introIsSkipped() const;
+	bool frameTimingsAreShown() const;
+	const std::string &getFrameTimingsFile() const;
+	const std::string &getTraceFile() const;
+	const std::string &getCPUFeatureTier() const;
 
 	void setScreenWidth(int width);
 	void setScreenHeight(int height);
@@ -63,6 +87,12 @@ public:
 	void setVerticalFOV(double fov);
 	void setLetterboxAspect(double aspect);
 	void setCursorScale(double cursorScale);
+	void setRenderThreadCount(int count);
+	void setPinRenderThreads(bool pin);
+	void setPipelinedRendering(bool pipelined);
+	void setFull3DRendering(bool full3D);
+	void setTiled3DRendering(bool tiled3D);
+	void setPalettedRendering(bool paletted);
 	void setHorizontalSensitivity(double hSensitivity);
 	void setVerticalSensitivity(double vSensitivity);
     void setSoundfont(std::string sfont);
@@ -71,6 +101,10 @@ public:
 	void setSoundChannelCount(int count);
 	void setArenaPath(std::string path);
 	void setSkipIntro(bool skip);
+	void setShowFrameTimings(bool show);
+	void setFrameTimingsFile(std::string file);
+	void setTraceFile(std::string file);
+	void setCPUFeatureTier(std::string tier);
 };
 
 #endif
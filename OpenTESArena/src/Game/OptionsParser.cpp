@@ -16,6 +16,12 @@ const std::string OptionsParser::RESOLUTION_SCALE_KEY = "ResolutionScale";
 const std::string OptionsParser::VERTICAL_FOV_KEY = "VerticalFieldOfView";
 const std::string OptionsParser::LETTERBOX_ASPECT_KEY = "LetterboxAspect";
 const std::string OptionsParser::CURSOR_SCALE_KEY = "CursorScale";
+const std::string OptionsParser::RENDER_THREAD_COUNT_KEY = "RenderThreadCount";
+const std::string OptionsParser::PIN_RENDER_THREADS_KEY = "PinRenderThreads";
+const std::string OptionsParser::PIPELINED_RENDERING_KEY = "PipelinedRendering";
+const std::string OptionsParser::FULL_3D_RENDERING_KEY = "Full3DRendering";
+const std::string OptionsParser::TILED_3D_RENDERING_KEY = "Tiled3DRendering";
+const std::string OptionsParser::PALETTED_RENDERING_KEY = "PalettedRendering";
 const std::string OptionsParser::H_SENSITIVITY_KEY = "HorizontalSensitivity";
 const std::string OptionsParser::V_SENSITIVITY_KEY = "VerticalSensitivity";
 const std::string OptionsParser::MUSIC_VOLUME_KEY = "MusicVolume";
@@ -24,6 +30,10 @@ const std::string OptionsParser::SOUNDFONT_KEY = "Soundfont";
 const std::string OptionsParser::SOUND_CHANNELS_KEY = "SoundChannels";
 const std::string OptionsParser::ARENA_PATH_KEY = "ArenaPath";
 const std::string OptionsParser::SKIP_INTRO_KEY = "SkipIntro";
+const std::string OptionsParser::SHOW_FRAME_TIMINGS_KEY = "ShowFrameTimings";
+const std::string OptionsParser::FRAME_TIMINGS_FILE_KEY = "FrameTimingsFile";
+const std::string OptionsParser::TRACE_FILE_KEY = "TraceFile";
+const std::string OptionsParser::CPU_FEATURE_TIER_KEY = "CPUFeatureTier";
 
 std::unique_ptr<Options> OptionsParser::parse()
 {
@@ -42,6 +52,12 @@ std::unique_ptr<Options> OptionsParser::parse()
 	double verticalFOV = textMap.getDouble(OptionsParser::VERTICAL_FOV_KEY);
 	double letterboxAspect = textMap.getDouble(OptionsParser::LETTERBOX_ASPECT_KEY);
 	double cursorScale = textMap.getDouble(OptionsParser::CURSOR_SCALE_KEY);
+	int renderThreadCount = textMap.getInteger(OptionsParser::RENDER_THREAD_COUNT_KEY);
+	bool pinRenderThreads = textMap.getBoolean(OptionsParser::PIN_RENDER_THREADS_KEY);
+	bool pipelinedRendering = textMap.getBoolean(OptionsParser::PIPELINED_RENDERING_KEY);
+	bool full3DRendering = textMap.getBoolean(OptionsParser::FULL_3D_RENDERING_KEY);
+	bool tiled3DRendering = textMap.getBoolean(OptionsParser::TILED_3D_RENDERING_KEY);
+	bool palettedRendering = textMap.getBoolean(OptionsParser::PALETTED_RENDERING_KEY);
 
 	// Input.
 	double hSensitivity = textMap.getDouble(OptionsParser::H_SENSITIVITY_KEY);
@@ -56,11 +72,18 @@ std::unique_ptr<Options> OptionsParser::parse()
 	// Miscellaneous.
 	std::string arenaPath = textMap.getString(OptionsParser::ARENA_PATH_KEY);
 	bool skipIntro = textMap.getBoolean(OptionsParser::SKIP_INTRO_KEY);
+	bool showFrameTimings = textMap.getBoolean(OptionsParser::SHOW_FRAME_TIMINGS_KEY);
+	std::string frameTimingsFile = textMap.getString(OptionsParser::FRAME_TIMINGS_FILE_KEY);
+	std::string traceFile = textMap.getString(OptionsParser::TRACE_FILE_KEY);
+	std::string cpuFeatureTier = textMap.getString(OptionsParser::CPU_FEATURE_TIER_KEY);
 	
 	return std::unique_ptr<Options>(new Options(std::move(arenaPath),
 		screenWidth, screenHeight, fullscreen, targetFPS, resolutionScale, verticalFOV,
-		letterboxAspect, cursorScale, hSensitivity, vSensitivity, std::move(soundfont), 
-		musicVolume, soundVolume, soundChannels, skipIntro));
+		letterboxAspect, cursorScale, renderThreadCount, pinRenderThreads, pipelinedRendering,
+		full3DRendering, tiled3DRendering, palettedRendering, hSensitivity, vSensitivity,
+		std::move(soundfont), musicVolume, soundVolume, soundChannels, skipIntro,
+		showFrameTimings, std::move(frameTimingsFile), std::move(traceFile),
+		std::move(cpuFeatureTier)));
 }
 
 void OptionsParser::save(const Options &options)
@@ -23,6 +23,12 @@ private:
 	static const std::string VERTICAL_FOV_KEY;
 	static const std::string LETTERBOX_ASPECT_KEY;
 	static const std::string CURSOR_SCALE_KEY;
+	static const std::string RENDER_THREAD_COUNT_KEY;
+	static const std::string PIN_RENDER_THREADS_KEY;
+	static const std::string PIPELINED_RENDERING_KEY;
+	static const std::string FULL_3D_RENDERING_KEY;
+	static const std::string TILED_3D_RENDERING_KEY;
+	static const std::string PALETTED_RENDERING_KEY;
 
 	// Input.
 	static const std::string H_SENSITIVITY_KEY;
@@ -37,6 +43,10 @@ private:
 	// Miscellaneous.
 	static const std::string ARENA_PATH_KEY;
 	static const std::string SKIP_INTRO_KEY;
+	static const std::string SHOW_FRAME_TIMINGS_KEY;
+	static const std::string FRAME_TIMINGS_FILE_KEY;
+	static const std::string TRACE_FILE_KEY;
+	static const std::string CPU_FEATURE_TIER_KEY;
 
 	OptionsParser() = delete;
 	OptionsParser(const OptionsParser&) = delete;
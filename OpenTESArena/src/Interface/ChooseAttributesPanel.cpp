@@ -134,8 +134,11 @@ ChooseAttributesPanel::ChooseAttributesPanel(Game *game,
 
 			// Initialize 3D renderer.
 			auto &renderer = game->getRenderer();
-			renderer.initializeWorldRendering(
-				game->getOptions().getResolutionScale(), false);
+			const auto &options = game->getOptions();
+			renderer.initializeWorldRendering(options.getResolutionScale(), false,
+				options.getRenderThreadCount(), options.renderThreadsArePinned(),
+				options.renderingIsPipelined(), options.renderingIsFull3D(),
+				options.renderingIsTiled3D(), options.renderingIsPaletted());
 
 			// Send some textures and test geometry to renderer memory. Eventually
 			// this will be moved out to another data class, maybe stored in the game
@@ -335,6 +338,12 @@ ChooseAttributesPanel::ChooseAttributesPanel(Game *game,
 			// Add some distinctive test textures.
 			auto &textureManager = this->getGame()->getTextureManager();
 			textureManager.setPalette(PaletteFile::fromName(PaletteName::Default));
+
+			// The world textures all use the default palette, so it's also the palette
+			// for paletted rendering.
+			const PaletteARGB paletteColors = toPaletteARGB(textureManager.getPalette());
+			renderer.updatePalette(paletteColors.data());
+
 			std::vector<const SDL_Surface*> surfaces = {
 				textureManager.getSurfaces("CASA.SET").at(3),
 				textureManager.getSurfaces("CASF.SET").at(3),
@@ -344,7 +353,7 @@ ChooseAttributesPanel::ChooseAttributesPanel(Game *game,
 			for (const auto *surface : surfaces)
 			{
 				renderer.addTexture(static_cast<uint32_t*>(surface->pixels), 
-					surface->w, surface->h);
+					surface->w, surface->h, true);
 			}
 			// -- end test --
 
@@ -370,7 +379,7 @@ ChooseAttributesPanel::ChooseAttributesPanel(Game *game,
 			// -- test --
 
 			// Set random voxels. These voxel IDs will refer to voxel data.
-			char *voxels = gameData->getVoxelGrid().getVoxels();
+			VoxelGrid &worldGrid = gameData->getVoxelGrid();
 			Random random(0);
 
 			for (int k = 0; k < gridDepth; ++k)
@@ -378,9 +387,7 @@ ChooseAttributesPanel::ChooseAttributesPanel(Game *game,
 				for (int i = 0; i < gridWidth; ++i)
 				{
 					// Ground.
-					const int j = 0;
-					const int index = i + (j * gridWidth) + (k * gridWidth * gridHeight);
-					voxels[index] = 1 + random.next(3);
+					worldGrid.setVoxel(i, 0, k, static_cast<char>(1 + random.next(3)));
 				}
 			}
 
@@ -389,9 +396,7 @@ ChooseAttributesPanel::ChooseAttributesPanel(Game *game,
 				const int x = random.next(gridWidth);
 				const int y = 1 + random.next(gridHeight - 1);
 				const int z = random.next(gridDepth);
-
-				const int index = x + (y * gridWidth) + (z * gridWidth * gridHeight);
-				voxels[index] = 1 + random.next(3);
+				worldGrid.setVoxel(x, y, z, static_cast<char>(1 + random.next(3)));
 			}
 			// -- end test --
 
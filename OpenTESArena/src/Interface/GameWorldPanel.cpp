@@ -39,6 +39,8 @@
 #include "../Rendering/Surface.h"
 #include "../Rendering/Texture.h"
 #include "../Utilities/Debug.h"
+#include "../Utilities/FrameTimings.h"
+#include "../Utilities/String.h"
 
 namespace
 {
@@ -181,11 +183,18 @@ void GameWorldPanel::handleEvent(const SDL_Event &e)
 
 	bool escapePressed = (e.type == SDL_KEYDOWN) &&
 		(e.key.keysym.sym == SDLK_ESCAPE);
+	bool frameTimingsHotkeyPressed = (e.type == SDL_KEYDOWN) &&
+		(e.key.keysym.sym == SDLK_F3);
 
 	if (escapePressed)
 	{
 		this->pauseButton->click(this->getGame());
 	}
+	else if (frameTimingsHotkeyPressed)
+	{
+		auto &options = this->getGame()->getOptions();
+		options.setShowFrameTimings(!options.frameTimingsAreShown());
+	}
 
 	bool leftClick = (e.type == SDL_MOUSEBUTTONDOWN) &&
 		(e.button.button == SDL_BUTTON_LEFT);
@@ -618,6 +627,28 @@ void GameWorldPanel::drawDebugText(Renderer &renderer)
 	renderer.drawToOriginal(tempText.getTexture(), tempText.getX(), tempText.getY());
 }
 
+void GameWorldPanel::drawFrameTimings(Renderer &renderer)
+{
+	const FrameTimings &frameTimings = renderer.getFrameTimings();
+	const double frameMS = frameTimings.getFrameSeconds() * 1000.0;
+
+	std::string text = "Frame: " + String::toFixedString(frameMS, 2) + " ms";
+	for (int i = 0; i < frameTimings.getStageCount(); ++i)
+	{
+		const double stageMS = frameTimings.getStageSeconds(i) * 1000.0;
+		text += "\n" + frameTimings.getStageName(i) + ": " +
+			String::toFixedString(stageMS, 2) + " ms";
+	}
+
+	// Right-aligned at the top of the screen, opposite the debug text.
+	TextBox tempText(0, 2, Color::White, text,
+		this->getGame()->getFontManager().getFont(FontName::D),
+		TextAlignment::Left, renderer);
+	const int textWidth = tempText.getSurface()->w;
+	renderer.drawToOriginal(tempText.getTexture(),
+		Renderer::ORIGINAL_WIDTH - textWidth - 2, tempText.getY());
+}
+
 void GameWorldPanel::updateCursorRegions(int width, int height)
 {
 	// Scale ratios.
@@ -724,6 +755,9 @@ void GameWorldPanel::render(Renderer &renderer)
 	auto &gameData = this->getGame()->getGameData();
 	renderer.renderWorld(gameData.getVoxelGrid());
 
+	// Everything else drawn here is interface.
+	FrameTimings::Scope interfaceTimingScope(renderer.getFrameTimings(), "Interface");
+
 	// Set screen palette.
 	auto &textureManager = this->getGame()->getTextureManager();
 	textureManager.setPalette(PaletteFile::fromName(PaletteName::Default));
@@ -734,6 +768,11 @@ void GameWorldPanel::render(Renderer &renderer)
 	// Draw some debug text.
 	this->drawDebugText(renderer);
 
+	if (this->getGame()->getOptions().frameTimingsAreShown())
+	{
+		this->drawFrameTimings(renderer);
+	}
+
 	// Draw game world interface.
 	const auto &gameInterface = textureManager.getTexture(
 		TextureFile::fromName(TextureName::GameWorldInterface));
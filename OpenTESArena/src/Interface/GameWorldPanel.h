@@ -42,6 +42,9 @@ private:
 
 	// Draws some debug text.
 	void drawDebugText(Renderer &renderer);
+
+	// Draws the time spent in each stage of the last frame.
+	void drawFrameTimings(Renderer &renderer);
 public:
 	// Constructs the game world panel. The GameData object in Game must be
 	// initialized.
@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <fstream>
+#include <vector>
 
 #include "PPMFile.h"
 
@@ -13,9 +14,10 @@ std::unique_ptr<uint32_t[]> PPMFile::read(const std::string &filename,
 	const std::string text = File::toString(filename);
 	const std::vector<std::string> lines = String::split(text, '\n');
 
-	// Make sure the PPM type is P3 (ASCII format).
+	// Make sure the PPM type is P3 (ASCII format) or P6 (binary format).
 	std::string ppmType = String::trimLines(lines.at(0));
-	Debug::check(ppmType.compare("P3") == 0, "PPMFile",
+	const bool binary = ppmType.compare("P6") == 0;
+	Debug::check(binary || (ppmType.compare("P3") == 0), "PPMFile",
 		"Unrecognized PPM type \"" + ppmType + "\".");
 
 	// Skip the comment at index 1.
@@ -36,6 +38,28 @@ std::unique_ptr<uint32_t[]> PPMFile::read(const std::string &filename,
 	std::unique_ptr<uint32_t[]> pixels(new uint32_t[width * height]);
 	std::fill(pixels.get(), pixels.get() + (width * height), 0);
 
+	if (binary)
+	{
+		// The RGB bytes start after the header's fourth line.
+		size_t offset = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			offset = text.find('\n', offset) + 1;
+		}
+
+		Debug::check((text.size() - offset) >= static_cast<size_t>(width * height * 3),
+			"PPMFile", "Not enough pixels in \"" + filename + "\".");
+
+		const uint8_t *components = reinterpret_cast<const uint8_t*>(text.data() + offset);
+		for (int i = 0; i < (width * height); ++i)
+		{
+			const uint8_t *component = components + (i * 3);
+			pixels[i] = (component[0] << 16) | (component[1] << 8) | component[2];
+		}
+
+		return pixels;
+	}
+
 	for (int y = 0; y < height; ++y)
 	{
 		// A component here is an ASCII value between 0-255.
@@ -65,30 +89,25 @@ std::unique_ptr<uint32_t[]> PPMFile::read(const std::string &filename,
 void PPMFile::write(const uint32_t *pixels, int width, int height,
 	const std::string &comment, const std::string &filename)
 {
-	std::ofstream ofs(filename);
+	std::ofstream ofs(filename, std::ios::binary);
 	const int uchar_max = 255;
 
 	// Write PPM header.
-	ofs << "P3" << "\n" << ("# " + comment) << "\n" << std::to_string(width) << " " <<
+	ofs << "P6" << "\n" << ("# " + comment) << "\n" << std::to_string(width) << " " <<
 		std::to_string(height) << "\n" << std::to_string(uchar_max) << "\n";
 
-	// Write color data out to file.
-	for (int y = 0; y < height; ++y)
+	// Write color data out to file, three bytes per pixel. That's about a third of
+	// the size of the ASCII format.
+	std::vector<char> components(width * height * 3);
+	for (int i = 0; i < (width * height); ++i)
 	{
-		for (int x = 0; x < width; ++x)
-		{
-			// Assume 0x00RRGGBB color format.
-			const uint32_t color = pixels[x + (y * width)];
-			const uint8_t r = static_cast<uint8_t>(color >> 16);
-			const uint8_t g = static_cast<uint8_t>(color >> 8);
-			const uint8_t b = static_cast<uint8_t>(color);
-
-			ofs << std::to_string(r) << " " << std::to_string(g) << " " <<
-				std::to_string(b) << " ";
-		}
-
-		ofs << "\n";
+		// Assume 0x00RRGGBB color format.
+		const uint32_t color = pixels[i];
+		components[i * 3] = static_cast<char>(color >> 16);
+		components[(i * 3) + 1] = static_cast<char>(color >> 8);
+		components[(i * 3) + 2] = static_cast<char>(color);
 	}
 
+	ofs.write(components.data(), components.size());
 	ofs.close();
 }
@@ -5,9 +5,11 @@
 #include <memory>
 #include <string>
 
-// Simple static class for reading and writing type P3 PPM image files.
+// Simple static class for reading type P3 (ASCII) and P6 (binary) PPM image files,
+// and writing type P6 ones.
 
-// PPM is an easy, uncompressed image format.
+// PPM is an easy, uncompressed image format. The header is expected to be the type,
+// a comment, the dimensions, and the max color value, each on its own line.
 
 class PPMFile
 {
@@ -2,9 +2,25 @@
 #define PALETTE_H
 
 #include <array>
+#include <cstdint>
 
 #include "Color.h"
 
 typedef std::array<Color, 256> Palette;
 
+// A palette's colors as ARGB8888, for converting whole images of palette indices at
+// once (see Kernels::expandPalette()).
+typedef std::array<uint32_t, 256> PaletteARGB;
+
+inline PaletteARGB toPaletteARGB(const Palette &palette)
+{
+	PaletteARGB colors;
+	for (size_t i = 0; i < palette.size(); ++i)
+	{
+		colors[i] = palette[i].toARGB();
+	}
+
+	return colors;
+}
+
 #endif
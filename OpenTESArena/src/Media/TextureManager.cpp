@@ -19,6 +19,7 @@
 #include "../Rendering/Renderer.h"
 #include "../Rendering/Surface.h"
 #include "../Utilities/Debug.h"
+#include "../Utilities/Profiler.h"
 #include "../Utilities/String.h"
 
 #include "components/vfs/manager.hpp"
@@ -66,6 +67,8 @@ void TextureManager::loadIMGPalette(const std::string &imgName)
 
 void TextureManager::loadPalette(const std::string &paletteName)
 {
+	Profiler::Zone zone("TextureManager::loadPalette");
+
 	// Don't load the same palette more than once.
 	assert(this->palettes.find(paletteName) == this->palettes.end());
 
@@ -413,6 +416,9 @@ const std::vector<Texture> &TextureManager::getTextures(
 		return setIter->second;
 	}
 
+	// Only loads are profiled, since this is called for cached sets every frame.
+	Profiler::Zone zone("TextureManager::getTextures");
+
 	// Do not use a built-in palette for texture sets.
 	Debug::check(!this->paletteIsBuiltIn(paletteName), "Texture Manager",
 		"Image sets (i.e., .SET files) do not have built-in palettes.");
@@ -578,6 +584,11 @@ const std::vector<Texture> &TextureManager::getTextures(const std::string &filen
 	return this->getTextures(filename, this->activePalette);
 }
 
+const Palette &TextureManager::getPalette() const
+{
+	return this->palettes.at(this->activePalette);
+}
+
 void TextureManager::setPalette(const std::string &paletteName)
 {
 	// Check if the palette hasn't already been loaded.
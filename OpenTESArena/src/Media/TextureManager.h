@@ -70,6 +70,9 @@ public:
 		const std::string &paletteName);
 	const std::vector<Texture> &getTextures(const std::string &filename);
 
+	// Gets the active palette.
+	const Palette &getPalette() const;
+
 	// Sets the palette to use for subsequent images. The source of the palette can be
 	// from a loose .COL file, or can be built into an IMG. If the IMG does not have a 
 	// built-in palette, an error occurs.
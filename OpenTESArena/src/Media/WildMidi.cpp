@@ -6,6 +6,7 @@
 #include <cassert>
 
 #include "../Utilities/Debug.h"
+#include "../Utilities/Profiler.h"
 
 #include "components/vfs/manager.hpp"
 
@@ -91,6 +92,8 @@ WildMidiDevice::~WildMidiDevice()
 
 MidiSongPtr WildMidiDevice::open(const std::string &name)
 {
+	Profiler::Zone zone("WildMidiDevice::open");
+
 	if (sInitState < 0)
 		return MidiSongPtr(nullptr);
 
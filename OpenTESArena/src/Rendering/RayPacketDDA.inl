@@ -0,0 +1,165 @@
+// Steps a packet of 3D rays from the eye through the voxel grid with the same DDA as
+// SoftwareRenderer::castRay(), one ray per SIMD lane and in single precision. Each
+// step, every ray still going advances along its own nearest axis, and rays that hit
+// something, leave the grid, or reach the view distance are masked off. Empty space
+// isn't skipped, since the rays in a packet would rarely skip the same distance.
+
+// This is included once for each SIMD tier in SoftwareRenderer.cpp, inside a
+// namespace that has RAY_PACKET_SIZE, PacketReal, PacketInt, and the packet helpers
+// for that tier. RAY_PACKET_TARGET is the tier's function target (see CPUFeatures.h).
+
+RAY_PACKET_TARGET
+void castRayPacket(RayPacket &packet, const Int3 &startCell, const Real3 &eyeOffset,
+	Real viewDistSquared, const VoxelGrid &voxelGrid)
+{
+	const double voxelHeight = voxelGrid.getVoxelHeight();
+	const double eyeYRelativeFloor = static_cast<double>(startCell.y) * voxelHeight;
+
+	// Get dimensions of the voxel grid.
+	const int gridWidth = voxelGrid.getWidth();
+	const int gridHeight = voxelGrid.getHeight();
+	const int gridDepth = voxelGrid.getDepth();
+
+	const PacketReal dirX = packetLoad(packet.dirXs);
+	const PacketReal dirY = packetLoad(packet.dirYs);
+	const PacketReal dirZ = packetLoad(packet.dirZs);
+	const PacketReal negativeDirX = packetLess(dirX, packetSet(0.0f));
+	const PacketReal negativeDirY = packetLess(dirY, packetSet(0.0f));
+	const PacketReal negativeDirZ = packetLess(dirZ, packetSet(0.0f));
+
+	// The directions are normalized, so the delta distances simplify to one over the
+	// magnitude of each component (clearing the sign bit gives the magnitude).
+	const PacketReal one = packetSet(1.0f);
+	const PacketReal signBit = packetSet(-0.0f);
+	const PacketReal deltaDistX = packetDiv(one, packetAndNot(signBit, dirX));
+	const PacketReal deltaDistY = packetDiv(one, packetAndNot(signBit, dirY));
+	const PacketReal deltaDistZ = packetDiv(one, packetAndNot(signBit, dirZ));
+
+	// Step directions.
+	const PacketInt positiveStep = packetSet(1);
+	const PacketInt negativeStep = packetSet(-1);
+	const PacketInt stepX = packetSelect(negativeDirX, negativeStep, positiveStep);
+	const PacketInt stepY = packetSelect(negativeDirY, negativeStep, positiveStep);
+	const PacketInt stepZ = packetSelect(negativeDirZ, negativeStep, positiveStep);
+
+	// Initial side distances. The eye's distance to each side of the start voxel is
+	// the same for every ray.
+	PacketReal sideDistX = packetMul(packetSelect(negativeDirX,
+		packetSet(static_cast<float>(eyeOffset.x)),
+		packetSet(static_cast<float>(1.0 - eyeOffset.x))), deltaDistX);
+	PacketReal sideDistY = packetMul(packetSelect(negativeDirY,
+		packetSet(static_cast<float>(eyeOffset.y)),
+		packetSet(static_cast<float>(voxelHeight - eyeOffset.y))), deltaDistY);
+	PacketReal sideDistZ = packetMul(packetSelect(negativeDirZ,
+		packetSet(static_cast<float>(eyeOffset.z)),
+		packetSet(static_cast<float>(1.0 - eyeOffset.z))), deltaDistZ);
+
+	// Combined corner offsets for the distance stepped, with a step of -1 or 1 (see
+	// castRay()).
+	const PacketReal cellOffsetX = packetSelect(negativeDirX,
+		packetSet(static_cast<float>(1 - startCell.x)),
+		packetSet(static_cast<float>(-(startCell.x + 1))));
+	const PacketReal cellOffsetY = packetSelect(negativeDirY,
+		packetSet(static_cast<float>(voxelHeight - eyeYRelativeFloor)),
+		packetSet(static_cast<float>(-(eyeYRelativeFloor + voxelHeight))));
+	const PacketReal cellOffsetZ = packetSelect(negativeDirZ,
+		packetSet(static_cast<float>(1 - startCell.z)),
+		packetSet(static_cast<float>(-(startCell.z + 1))));
+
+	const PacketInt zero = packetSet(0);
+	const PacketInt gridWidthPacket = packetSet(gridWidth);
+	const PacketInt gridHeightPacket = packetSet(gridHeight);
+	const PacketInt gridDepthPacket = packetSet(gridDepth);
+	const PacketInt axisX = packetSet(0);
+	const PacketInt axisY = packetSet(1);
+	const PacketInt axisZ = packetSet(2);
+	const PacketReal viewDistSquaredPacket = packetSet(static_cast<float>(viewDistSquared));
+
+	PacketInt cellX = packetSet(startCell.x);
+	PacketInt cellY = packetSet(startCell.y);
+	PacketInt cellZ = packetSet(startCell.z);
+	PacketInt axis = axisX;
+	PacketReal active = packetLess(zero, packetLoad(packet.laneIsActive));
+
+	// ID of each ray's hit voxel. Zero (air) by default.
+	int *hitIDs = packet.hitIDs;
+	std::fill(hitIDs, hitIDs + RAY_PACKET_SIZE, 0);
+
+	int *cellXs = packet.cellXs;
+	int *cellYs = packet.cellYs;
+	int *cellZs = packet.cellZs;
+	const char *voxels = voxelGrid.getVoxels();
+	const uint64_t *occupancy = voxelGrid.getOccupancy();
+	const int occupancyWidth = voxelGrid.getOccupancyWidth();
+	const int tileShift = VoxelGrid::OCCUPANCY_TILE_SHIFT;
+	const int tileMask = (1 << tileShift) - 1;
+	int activeBits = packetMaskBits(active);
+	while (activeBits != 0)
+	{
+		// Check each active ray's voxel in the occupancy bitmap. SSE2 has no gather
+		// instruction, so this is done one lane at a time.
+		packetStore(cellXs, cellX);
+		packetStore(cellYs, cellY);
+		packetStore(cellZs, cellZ);
+		for (int i = 0; i < RAY_PACKET_SIZE; ++i)
+		{
+			if (((activeBits >> i) & 1) != 0)
+			{
+				const uint64_t tile = occupancy[(cellXs[i] >> tileShift) +
+					(cellYs[i] * occupancyWidth) +
+					((cellZs[i] >> tileShift) * occupancyWidth * gridHeight)];
+				const int tileBit = (cellXs[i] & tileMask) | ((cellZs[i] & tileMask) << tileShift);
+				if (((tile >> tileBit) & 1) != 0)
+				{
+					hitIDs[i] = voxels[cellXs[i] + (cellYs[i] * gridWidth) +
+						(cellZs[i] * gridWidth * gridHeight)];
+				}
+			}
+		}
+
+		// Rays that hit something stay in that voxel.
+		active = packetAndNot(packetLess(zero, packetLoad(hitIDs)), active);
+
+		// Step each remaining ray along the axis with the nearest side.
+		const PacketReal xIsNearest = packetAnd(
+			packetLess(sideDistX, sideDistY), packetLess(sideDistX, sideDistZ));
+		const PacketReal yIsNearest = packetAndNot(xIsNearest, packetLess(sideDistY, sideDistZ));
+		const PacketReal stepsX = packetAnd(active, xIsNearest);
+		const PacketReal stepsY = packetAnd(active, yIsNearest);
+		const PacketReal stepsZ = packetAndNot(yIsNearest, packetAndNot(xIsNearest, active));
+
+		sideDistX = packetSelect(stepsX, packetAdd(sideDistX, deltaDistX), sideDistX);
+		cellX = packetSelect(stepsX, packetAdd(cellX, stepX), cellX);
+		axis = packetSelect(stepsX, axisX, axis);
+
+		sideDistY = packetSelect(stepsY, packetAdd(sideDistY, deltaDistY), sideDistY);
+		cellY = packetSelect(stepsY, packetAdd(cellY, stepY), cellY);
+		axis = packetSelect(stepsY, axisY, axis);
+
+		sideDistZ = packetSelect(stepsZ, packetAdd(sideDistZ, deltaDistZ), sideDistZ);
+		cellZ = packetSelect(stepsZ, packetAdd(cellZ, stepZ), cellZ);
+		axis = packetSelect(stepsZ, axisZ, axis);
+
+		// Rays stop once they leave the grid or step past the view distance.
+		const PacketReal cellIsValid = packetAnd(packetAnd(
+			packetAndNot(packetLess(cellX, zero), packetLess(cellX, gridWidthPacket)),
+			packetAndNot(packetLess(cellY, zero), packetLess(cellY, gridHeightPacket))),
+			packetAndNot(packetLess(cellZ, zero), packetLess(cellZ, gridDepthPacket)));
+
+		const PacketReal cellDiffX = packetAdd(packetToReal(cellX), cellOffsetX);
+		const PacketReal cellDiffY = packetAdd(packetToReal(cellY), cellOffsetY);
+		const PacketReal cellDiffZ = packetAdd(packetToReal(cellZ), cellOffsetZ);
+		const PacketReal cellDistSquared = packetAdd(packetAdd(
+			packetMul(cellDiffX, cellDiffX), packetMul(cellDiffY, cellDiffY)),
+			packetMul(cellDiffZ, cellDiffZ));
+
+		active = packetAnd(active,
+			packetAnd(cellIsValid, packetLess(cellDistSquared, viewDistSquaredPacket)));
+		activeBits = packetMaskBits(active);
+	}
+
+	packetStore(cellXs, cellX);
+	packetStore(cellYs, cellY);
+	packetStore(cellZs, cellZ);
+	packetStore(packet.axes, axis);
+}
@@ -0,0 +1,174 @@
+#include <cassert>
+#include <string>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "RenderThreadPool.h"
+
+#include "../Utilities/Debug.h"
+#include "../Utilities/Profiler.h"
+
+RenderThreadPool::RenderThreadPool(int threadCount, bool pinThreads)
+{
+	assert(threadCount >= 0);
+
+	// Obtain the number of threads to use. "hardware_concurrency()" might return 0,
+	// so it needs to be clamped positive.
+	const int hardwareThreadCount = static_cast<int>(std::thread::hardware_concurrency());
+	if (threadCount == 0)
+	{
+		threadCount = hardwareThreadCount;
+
+		if (threadCount == 0)
+		{
+			Debug::mention("Render Thread Pool", "hardware_concurrency() returned 0.");
+			threadCount = 1;
+		}
+	}
+
+	this->generation = 0;
+	this->threadsRemaining = 0;
+	this->stopping = false;
+
+	Debug::mention("Render Thread Pool", "Starting " + std::to_string(threadCount) +
+		" render thread(s)" + (pinThreads ? " pinned to cores." : "."));
+
+	for (int i = 0; i < threadCount; ++i)
+	{
+		this->threads.push_back(std::thread(&RenderThreadPool::workerLoop, this, i));
+
+		if (pinThreads && (hardwareThreadCount > 0))
+		{
+			RenderThreadPool::pinThread(this->threads.back(), i % hardwareThreadCount);
+		}
+	}
+}
+
+RenderThreadPool::~RenderThreadPool()
+{
+	// Let any running job finish, then tell the workers to exit.
+	this->wait();
+
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+
+	this->jobCondition.notify_all();
+
+	for (auto &thread : this->threads)
+	{
+		thread.join();
+	}
+}
+
+void RenderThreadPool::pinThread(std::thread &thread, int coreIndex)
+{
+#if defined(_WIN32)
+	const DWORD_PTR mask = static_cast<DWORD_PTR>(1) << (coreIndex % (sizeof(DWORD_PTR) * 8));
+	if (SetThreadAffinityMask(static_cast<HANDLE>(thread.native_handle()), mask) == 0)
+	{
+		Debug::mention("Render Thread Pool", "Couldn't pin thread to core " +
+			std::to_string(coreIndex) + ".");
+	}
+#elif defined(__linux__)
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	CPU_SET(coreIndex, &cpuSet);
+	if (pthread_setaffinity_np(thread.native_handle(), sizeof(cpuSet), &cpuSet) != 0)
+	{
+		Debug::mention("Render Thread Pool", "Couldn't pin thread to core " +
+			std::to_string(coreIndex) + ".");
+	}
+#else
+	// Thread affinity isn't supported here (i.e., macOS only has affinity "hints").
+	static_cast<void>(thread);
+	static_cast<void>(coreIndex);
+#endif
+}
+
+void RenderThreadPool::workerLoop(int threadIndex)
+{
+	Profiler::setThreadName("Render thread " + std::to_string(threadIndex));
+
+	int lastGeneration = 0;
+
+	while (true)
+	{
+		std::function<void(int)> *currentJob;
+
+		// Park until a new job is started or the pool is being destroyed.
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->jobCondition.wait(lock, [this, lastGeneration]()
+			{
+				return this->stopping || (this->generation != lastGeneration);
+			});
+
+			if (this->stopping)
+			{
+				return;
+			}
+
+			lastGeneration = this->generation;
+			currentJob = &this->job;
+		}
+
+		// The job object isn't modified until every worker is done with it.
+		(*currentJob)(threadIndex);
+
+		// Wake the waiting thread if this was the last worker to finish.
+		bool lastThread;
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->threadsRemaining--;
+			lastThread = this->threadsRemaining == 0;
+		}
+
+		if (lastThread)
+		{
+			this->doneCondition.notify_all();
+		}
+	}
+}
+
+int RenderThreadPool::getThreadCount() const
+{
+	return static_cast<int>(this->threads.size());
+}
+
+void RenderThreadPool::start(std::function<void(int)> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		assert(this->threadsRemaining == 0);
+
+		this->job = std::move(job);
+		this->threadsRemaining = static_cast<int>(this->threads.size());
+		this->generation++;
+	}
+
+	this->jobCondition.notify_all();
+}
+
+void RenderThreadPool::wait()
+{
+	std::unique_lock<std::mutex> lock(this->mutex);
+	this->doneCondition.wait(lock, [this]()
+	{
+		return this->threadsRemaining == 0;
+	});
+}
+
+void RenderThreadPool::run(std::function<void(int)> job)
+{
+	this->start(std::move(job));
+	this->wait();
+}
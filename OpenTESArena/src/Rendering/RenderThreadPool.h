@@ -0,0 +1,60 @@
+#ifndef RENDER_THREAD_POOL_H
+#define RENDER_THREAD_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A set of long-lived worker threads for the software renderer. Creating and joining
+// new threads every frame is expensive on machines with many cores, so the workers
+// are created once and parked on a condition variable between jobs.
+
+// A job is a function given the index of the worker running it. Every worker runs
+// the job exactly once each time it is started.
+
+class RenderThreadPool
+{
+private:
+	std::vector<std::thread> threads;
+	std::function<void(int)> job; // Current job, given the worker's index.
+	std::mutex mutex;
+	std::condition_variable jobCondition; // Signaled when a job starts (or on exit).
+	std::condition_variable doneCondition; // Signaled when the last worker finishes.
+	int generation; // Incremented each time a job is started.
+	int threadsRemaining; // Workers that haven't finished the current job.
+	bool stopping; // True when the workers should exit.
+
+	// Sets the CPU core affinity of a worker thread. Does nothing on platforms
+	// that don't support it.
+	static void pinThread(std::thread &thread, int coreIndex);
+
+	// The loop each worker runs for the lifetime of the pool.
+	void workerLoop(int threadIndex);
+public:
+	// Creates the given number of workers. If the thread count is zero, one worker
+	// per hardware thread is used. If "pinThreads" is true, each worker is bound
+	// to its own CPU core.
+	RenderThreadPool(int threadCount, bool pinThreads);
+	RenderThreadPool(const RenderThreadPool&) = delete;
+	~RenderThreadPool();
+
+	RenderThreadPool &operator=(const RenderThreadPool&) = delete;
+
+	// Gets the number of worker threads.
+	int getThreadCount() const;
+
+	// Wakes the workers to run the given job and returns immediately. The previous
+	// job must have finished (see wait()).
+	void start(std::function<void(int)> job);
+
+	// Blocks until all workers have finished the current job. Returns immediately
+	// if there is no job running.
+	void wait();
+
+	// Convenience method for start() followed by wait().
+	void run(std::function<void(int)> job);
+};
+
+#endif
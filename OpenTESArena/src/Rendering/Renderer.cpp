@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <string>
 
 #include "SDL.h"
 
@@ -63,6 +64,9 @@ Renderer::Renderer(int width, int height, bool fullscreen, double letterboxAspec
 	this->gameWorldTexture = nullptr;
 	this->softwareRenderer = nullptr;
 	this->fullGameWindow = false;
+	this->pipelinedRendering = false;
+	this->worldFrameReady = false;
+	this->worldFrameUploaded = false;
 
 	// Set the original frame buffer to not use transparency by default.
 	this->useTransparencyBlending(false);
@@ -127,6 +131,39 @@ SDL_Renderer *Renderer::createRenderer()
 	return rendererContext;
 }
 
+void Renderer::addWorldTimings()
+{
+	const SoftwareRenderer::FrameTiming &frameTiming = this->softwareRenderer->getFrameTiming();
+	this->frameTimings.addTime("World clear", frameTiming.clearSeconds);
+	this->frameTimings.addTime("World visible flats", frameTiming.visibleFlatsSeconds);
+	this->frameTimings.addTime("World flat sort", frameTiming.flatSortSeconds);
+
+	// Each pass is the sum over all render threads, so it's CPU time, not wall time.
+	const auto &threadTimings = this->softwareRenderer->getThreadTimings();
+	double wallSeconds = 0.0;
+	double floorSeconds = 0.0;
+	double flatSeconds = 0.0;
+	double expandSeconds = 0.0;
+	for (const auto &timing : threadTimings)
+	{
+		wallSeconds += timing.wallSeconds;
+		floorSeconds += timing.floorSeconds;
+		flatSeconds += timing.flatSeconds;
+		expandSeconds += timing.expandSeconds;
+	}
+
+	this->frameTimings.addTime("World walls", wallSeconds);
+	this->frameTimings.addTime("World floors", floorSeconds);
+	this->frameTimings.addTime("World flats", flatSeconds);
+	this->frameTimings.addTime("World palette expansion", expandSeconds);
+
+	for (size_t i = 0; i < threadTimings.size(); ++i)
+	{
+		this->frameTimings.addTime("Render thread " + std::to_string(i),
+			threadTimings[i].busySeconds);
+	}
+}
+
 SDL_Surface *Renderer::getWindowSurface() const
 {
 	return SDL_GetWindowSurface(this->window);
@@ -196,6 +233,11 @@ SDL_Rect Renderer::getLetterboxDimensions() const
 	}
 }
 
+FrameTimings &Renderer::getFrameTimings()
+{
+	return this->frameTimings;
+}
+
 SDL_Surface *Renderer::getScreenshot() const
 {
 	const Int2 dimensions = this->getWindowDimensions();
@@ -322,8 +364,10 @@ void Renderer::resize(int width, int height, double resolutionScale)
 		Debug::check(this->gameWorldTexture != nullptr, "Renderer",
 			"Couldn't recreate game world texture, " + std::string(SDL_GetError()));
 
-		// Resize 3D renderer.
+		// Resize 3D renderer. Its last frame doesn't fit anymore.
 		this->softwareRenderer->resize(renderWidth, renderHeight);
+		this->worldFrameReady = false;
+		this->worldFrameUploaded = false;
 	}
 }
 
@@ -350,9 +394,14 @@ void Renderer::useTransparencyBlending(bool blend)
 		std::string(SDL_GetError()));
 }
 
-void Renderer::initializeWorldRendering(double resolutionScale, bool fullGameWindow)
+void Renderer::initializeWorldRendering(double resolutionScale, bool fullGameWindow,
+	int renderThreadCount, bool pinRenderThreads, bool pipelinedRendering,
+	bool full3DRendering, bool tiled3DRendering, bool palettedRendering)
 {
 	this->fullGameWindow = fullGameWindow;
+	this->pipelinedRendering = pipelinedRendering;
+	this->worldFrameReady = false;
+	this->worldFrameUploaded = false;
 
 	const int screenWidth = this->getWindowDimensions().x;
 	const int screenHeight = this->getWindowDimensions().y;
@@ -379,7 +428,10 @@ void Renderer::initializeWorldRendering(double resolutionScale, bool fullGameWin
 
 	// Initialize 3D rendering program.
 	this->softwareRenderer = std::unique_ptr<SoftwareRenderer>(new SoftwareRenderer(
-		renderWidth, renderHeight));
+		renderWidth, renderHeight, renderThreadCount, pinRenderThreads));
+	this->softwareRenderer->setFull3D(full3DRendering);
+	this->softwareRenderer->setTiled3D(tiled3DRendering);
+	this->softwareRenderer->setIndexedRendering(palettedRendering);
 }
 
 void Renderer::updateCamera(const Double3 &eye, const Double3 &direction, double fovY)
@@ -403,10 +455,22 @@ void Renderer::updateViewDistance(double viewDistance)
 	this->softwareRenderer->setViewDistance(viewDistance);
 }
 
-int Renderer::addTexture(const uint32_t *pixels, int width, int height)
+void Renderer::updatePalette(const uint32_t *colors)
+{
+	assert(this->softwareRenderer.get() != nullptr);
+	this->softwareRenderer->setPalette(colors);
+}
+
+void Renderer::updateOutputPalette(const uint32_t *colors)
+{
+	assert(this->softwareRenderer.get() != nullptr);
+	this->softwareRenderer->setOutputPalette(colors);
+}
+
+int Renderer::addTexture(const uint32_t *pixels, int width, int height, bool mipmapped)
 {
 	assert(this->softwareRenderer.get() != nullptr);
-	return this->softwareRenderer->addTexture(pixels, width, height);
+	return this->softwareRenderer->addTexture(pixels, width, height, mipmapped);
 }
 
 void Renderer::updateVoxel(int x, int y, int z, const std::vector<Rect3D> &rects,
@@ -577,18 +641,95 @@ void Renderer::renderWorld(const VoxelGrid &voxelGrid)
 	// The 3D renderer must be initialized.
 	assert(this->softwareRenderer.get() != nullptr);
 
-	// Render the game world to a frame buffer.
-	this->softwareRenderer->render(voxelGrid);
+	// How much of the game world changed since the last frame.
+	const SoftwareRenderer::FrameChange frameChange =
+		this->softwareRenderer->getFrameChange(voxelGrid);
 
-	int renderWidth;
-	SDL_QueryTexture(this->gameWorldTexture, nullptr, nullptr, &renderWidth, nullptr);
-
-	// Send the ARGB8888 pixels to the game world texture. Later, this step can be 
-	// skipped once using a graphics API.
-	const uint32_t *pixels = this->softwareRenderer->getPixels();
-	const int pitch = renderWidth * sizeof(*pixels);
-	SDL_UpdateTexture(this->gameWorldTexture, nullptr,
-		static_cast<const void*>(pixels), pitch);
+	void *texturePixels;
+	int texturePitch;
+	if (this->pipelinedRendering)
+	{
+		// The first frame has nothing to show yet, so it's rendered right away.
+		if (!this->worldFrameReady)
+		{
+			this->softwareRenderer->startRender(voxelGrid);
+			this->softwareRenderer->finishRender();
+			this->worldFrameReady = true;
+			this->worldFrameUploaded = false;
+		}
+
+		// Start ray casting the next frame while the last finished one is uploaded. 
+		// The render threads are waited on in present(), after the rest of the frame 
+		// has been drawn. Unlike the unpipelined path, the frame can't be ray cast 
+		// straight into a locked texture, because the texture has to be unlocked to 
+		// be presented while the next frame is still being drawn, so the finished 
+		// frame is copied instead.
+		{
+			FrameTimings::Scope timingScope(this->frameTimings, "World render");
+			this->softwareRenderer->startRender(voxelGrid);
+		}
+
+		// A reused frame is already in the texture (i.e., while standing still).
+		if (!this->worldFrameUploaded)
+		{
+			int renderWidth;
+			SDL_QueryTexture(this->gameWorldTexture, nullptr, nullptr, &renderWidth, nullptr);
+
+			const uint32_t *pixels = this->softwareRenderer->getPixels();
+			const int pitch = renderWidth * sizeof(*pixels);
+			FrameTimings::Scope timingScope(this->frameTimings, "Texture upload");
+			SDL_UpdateTexture(this->gameWorldTexture, nullptr,
+				static_cast<const void*>(pixels), pitch);
+			this->worldFrameUploaded = true;
+		}
+	}
+	else if (this->worldFrameReady && (frameChange == SoftwareRenderer::FrameChange::None))
+	{
+		// Nothing in the game world changed (i.e., the player is standing still), so 
+		// the texture still has the right frame.
+	}
+	else if ((frameChange == SoftwareRenderer::FrameChange::All) &&
+		(SDL_LockTexture(this->gameWorldTexture, nullptr, &texturePixels, &texturePitch) == 0))
+	{
+		// Render the game world straight into the streaming texture's memory, which 
+		// avoids copying the whole frame every frame.
+		{
+			FrameTimings::Scope timingScope(this->frameTimings, "World render");
+			this->softwareRenderer->render(voxelGrid,
+				static_cast<uint32_t*>(texturePixels), texturePitch);
+		}
+
+		this->addWorldTimings();
+		this->worldFrameReady = true;
+
+		FrameTimings::Scope timingScope(this->frameTimings, "Texture upload");
+		SDL_UnlockTexture(this->gameWorldTexture);
+	}
+	else
+	{
+		// Render the game world to a frame buffer. If only some flats changed, just 
+		// their columns are redrawn over the last frame, and if only the output palette
+		// changed, just the last frame's palette indices are converted again. The whole
+		// frame is copied, since a locked texture's old contents aren't kept.
+		{
+			FrameTimings::Scope timingScope(this->frameTimings, "World render");
+			this->softwareRenderer->render(voxelGrid);
+		}
+
+		this->addWorldTimings();
+		this->worldFrameReady = true;
+
+		int renderWidth;
+		SDL_QueryTexture(this->gameWorldTexture, nullptr, nullptr, &renderWidth, nullptr);
+
+		// Send the ARGB8888 pixels to the game world texture. Later, this step can be 
+		// skipped once using a graphics API.
+		const uint32_t *pixels = this->softwareRenderer->getPixels();
+		const int pitch = renderWidth * sizeof(*pixels);
+		FrameTimings::Scope timingScope(this->frameTimings, "Texture upload");
+		SDL_UpdateTexture(this->gameWorldTexture, nullptr,
+			static_cast<const void*>(pixels), pitch);
+	}
 
 	// Now copy to the native frame buffer (stretching if needed).
 	const int screenWidth = this->getWindowDimensions().x;
@@ -667,7 +808,26 @@ void Renderer::drawOriginalToNative()
 
 void Renderer::present()
 {
-	SDL_SetRenderTarget(this->renderer, nullptr);
-	SDL_RenderCopy(this->renderer, this->nativeTexture, nullptr, nullptr);
-	SDL_RenderPresent(this->renderer);
+	{
+		FrameTimings::Scope timingScope(this->frameTimings, "Present");
+		SDL_SetRenderTarget(this->renderer, nullptr);
+		SDL_RenderCopy(this->renderer, this->nativeTexture, nullptr, nullptr);
+		SDL_RenderPresent(this->renderer);
+	}
+
+	// Finish any pipelined 3D frame before the game world can change again. Its 
+	// timings are added to the frame that started it.
+	if ((this->softwareRenderer.get() != nullptr) &&
+		this->softwareRenderer->isRenderPending())
+	{
+		{
+			FrameTimings::Scope timingScope(this->frameTimings, "World wait");
+			if (this->softwareRenderer->finishRender())
+			{
+				this->worldFrameUploaded = false;
+			}
+		}
+
+		this->addWorldTimings();
+	}
 }
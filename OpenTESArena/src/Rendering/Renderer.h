@@ -9,6 +9,7 @@
 #include "Rect3D.h"
 #include "../Math/Vector2.h"
 #include "../Math/Vector3.h"
+#include "../Utilities/FrameTimings.h"
 
 // Acts as a wrapper for SDL_Renderer operations as well as 3D rendering operations.
 
@@ -34,12 +35,19 @@ private:
 	SDL_Renderer *renderer;
 	SDL_Texture *nativeTexture, *originalTexture, *gameWorldTexture; // Frame buffers.
 	std::unique_ptr<SoftwareRenderer> softwareRenderer; // 3D renderer.
+	FrameTimings frameTimings;
 	double letterboxAspect;
 	bool fullGameWindow; // Determines height of 3D frame buffer.
+	bool pipelinedRendering; // Ray casts the next frame while presenting the last one.
+	bool worldFrameReady; // True if the 3D renderer has a finished frame to show.
+	bool worldFrameUploaded; // True if the game world texture has the finished frame.
 
 	// Helper method for making a renderer context.
 	SDL_Renderer *createRenderer();
 
+	// Adds the 3D renderer's timings for its most recent frame to the frame timings.
+	void addWorldTimings();
+
 	// For use with window dimensions, etc.. No longer used for rendering.
 	SDL_Surface *getWindowSurface() const;
 public:
@@ -69,6 +77,10 @@ public:
 	// using the given letterbox aspect.
 	SDL_Rect getLetterboxDimensions() const;
 
+	// Gets the time spent in each stage of recent frames. Anything drawing a frame
+	// can add its own stages.
+	FrameTimings &getFrameTimings();
+
 	// Gets a screenshot of the current window. The returned surface should be freed
 	// by the caller with SDL_FreeSurface() when finished.
 	SDL_Surface *getScreenshot() const;
@@ -108,8 +120,16 @@ public:
 	// Initialize the renderer for the game world. The "fullGameWindow" argument 
 	// determines whether to render a "fullscreen" 3D image or just the part above 
 	// the game interface. If there is an existing renderer in memory, it will be 
-	// overwritten with the new one.
-	void initializeWorldRendering(double resolutionScale, bool fullGameWindow);
+	// overwritten with the new one. A render thread count of zero uses one thread 
+	// per hardware thread. Pipelined rendering shows each frame one frame late, so 
+	// ray casting can overlap with uploading and presenting. One frame is the most
+	// it can lag, since the software renderer has a single back buffer and the scene
+	// can't change while a frame is in flight. Full 3D rendering ray 
+	// casts every pixel instead of every column, optionally in square tiles. Paletted
+	// rendering draws the world as palette indices once a palette is given.
+	void initializeWorldRendering(double resolutionScale, bool fullGameWindow,
+		int renderThreadCount, bool pinRenderThreads, bool pipelinedRendering,
+		bool full3DRendering, bool tiled3DRendering, bool palettedRendering);
 
 	// Helper methods for interacting with render memory.
 	// - Eventually, the geometry methods here will be separated into "static" and
@@ -117,7 +137,9 @@ public:
 	void updateCamera(const Double3 &eye, const Double3 &direction, double fovY);
 	void updateGameTime(double gameTime);
 	void updateViewDistance(double viewDistance);
-	int addTexture(const uint32_t *pixels, int width, int height);
+	void updatePalette(const uint32_t *colors);
+	void updateOutputPalette(const uint32_t *colors); // For palette effects.
+	int addTexture(const uint32_t *pixels, int width, int height, bool mipmapped);
 	void updateVoxel(int x, int y, int z, const std::vector<Rect3D> &rects,
 		const std::vector<int> &textureIndices);
 	void updateVoxel(int x, int y, int z, const std::vector<Rect3D> &rects,
@@ -1,5 +1,7 @@
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <limits>
 #include <thread>
@@ -7,33 +9,377 @@
 #include "SoftwareRenderer.h"
 
 #include "../Math/Constants.h"
+#include "../Utilities/CPUFeatures.h"
 #include "../Utilities/Debug.h"
+#include "../Utilities/Kernels.h"
+#include "../Utilities/Profiler.h"
 #include "../World/VoxelData.h"
 #include "../World/VoxelGrid.h"
 
-SoftwareRenderer::SoftwareRenderer(int width, int height)
+// SIMD variants of the 3D ray packet DDA are compiled for their own targets, whatever
+// the rest of the build targets (see CPUFeatures.h).
+#ifdef CPU_FEATURES_X86
+#include <immintrin.h>
+#endif
+
+const int SoftwareRenderer::COLUMN_TILE_WIDTH = 16;
+const int SoftwareRenderer::SCREEN_TILE_SIZE = 16;
+const int SoftwareRenderer::FLOOR_ROW_TILE_HEIGHT = 4;
+const int SoftwareRenderer::INDEX_ROW_TILE_HEIGHT = 8;
+const int SoftwareRenderer::FOG_LEVELS = 64;
+const int SoftwareRenderer::FLAT_CHUNK_SIZE = 8;
+const int SoftwareRenderer::FLAT_SLOT_BITS = 20;
+const int SoftwareRenderer::MIN_SKIP_EMPTY_DISTANCE = 8;
+
+namespace
 {
-	// Initialize 2D frame buffers.
+	typedef SoftwareRenderer::Real Real;
+
+	// Converts world values to the renderer's precision.
+	SoftwareRenderer::Real2 toReal(const Double2 &value)
+	{
+		return SoftwareRenderer::Real2(static_cast<Real>(value.x), static_cast<Real>(value.y));
+	}
+
+	SoftwareRenderer::Real3 toReal(const Double3 &value)
+	{
+		return SoftwareRenderer::Real3(static_cast<Real>(value.x),
+			static_cast<Real>(value.y), static_cast<Real>(value.z));
+	}
+
+	// Rounds down to an int without std::floor(), which is a library call without
+	// SSE4.1.
+	int floorToInt(Real value)
+	{
+		const int truncated = static_cast<int>(value);
+		return truncated - ((static_cast<Real>(truncated) > value) ? 1 : 0);
+	}
+
+	// Fogs an ARGB8888 texel with a row from the fog table, returning 0x00RRGGBB.
+	uint32_t applyFog(uint32_t texel, const uint8_t *fogRow)
+	{
+		const uint32_t r = fogRow[(texel >> 16) & 0xFF];
+		const uint32_t g = fogRow[256 + ((texel >> 8) & 0xFF)];
+		const uint32_t b = fogRow[512 + (texel & 0xFF)];
+		return (r << 16) | (g << 8) | b;
+	}
+
+	// Fills a span of a frame buffer row.
+	void fillSpan(uint8_t *dst, int count, uint8_t value)
+	{
+		std::fill(dst, dst + count, value);
+	}
+
+	void fillSpan(uint32_t *dst, int count, uint32_t value)
+	{
+		Kernels::fill(dst, count, value);
+	}
+
+	// Fills each row of a frame buffer, or only the given column tiles of each row.
+	// The pitch is in elements.
+	template <typename T>
+	void fillFrameBuffer(T *pixels, int width, int height, int pitch, T value,
+		const std::vector<int> *columnTiles, int tileWidth)
+	{
+		for (int y = 0; y < height; ++y)
+		{
+			T *row = pixels + (y * pitch);
+			if (columnTiles != nullptr)
+			{
+				for (const int tile : *columnTiles)
+				{
+					const int startX = tile * tileWidth;
+					const int endX = std::min(startX + tileWidth, width);
+					fillSpan(row + startX, endX - startX, value);
+				}
+			}
+			else
+			{
+				fillSpan(row, width, value);
+			}
+		}
+	}
+
+	// Averages four ARGB8888 texels channel by channel, rounding to nearest.
+	uint32_t averageTexels(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+	{
+		uint32_t average = 0;
+		for (int shift = 0; shift < 32; shift += 8)
+		{
+			const uint32_t sum = ((a >> shift) & 0xFF) + ((b >> shift) & 0xFF) +
+				((c >> shift) & 0xFF) + ((d >> shift) & 0xFF);
+			average |= ((sum + 2) / 4) << shift;
+		}
+
+		return average;
+	}
+
+	// Gets how many of an axis's voxel boundaries a DDA ray crosses before the given
+	// distance, up to some maximum. Crossings exactly at the distance aren't counted,
+	// so the DDA loop still breaks ties between axes itself. This is in the DDA loop,
+	// so it takes the reciprocal of the axis's delta distance and avoids branches
+	// and std::ceil().
+	int getSkipCrossings(Real sideDist, Real invDeltaDist, Real exitDist,
+		int maxCrossings)
+	{
+		// Clamping also turns NaN into zero (i.e., infinity times zero for rays
+		// parallel to an axis).
+		const Real crossings = std::min(std::max(static_cast<Real>(0.0),
+			(exitDist - sideDist) * invDeltaDist), static_cast<Real>(maxCrossings));
+		const int count = static_cast<int>(crossings);
+		return count + ((static_cast<Real>(count) < crossings) ? 1 : 0);
+	}
+
+	// 3D rays are cast in packets of coherent rays (a small block of pixels), one ray
+	// per SIMD lane, using the widest tier the CPU supports. Each component has its
+	// own array so it can be loaded into SIMD registers. Without SSE2, each ray in a
+	// packet is cast by itself.
+	struct RayPacket
+	{
+		static const int MAX_SIZE = 8;
+
+		float dirXs[MAX_SIZE], dirYs[MAX_SIZE], dirZs[MAX_SIZE];
+		int laneIsActive[MAX_SIZE];
+
+		// The voxel each ray stopped in, the axis (X, Y, or Z as 0, 1, or 2) of the
+		// last face it crossed, and the ID of the voxel it hit (zero for air).
+		int cellXs[MAX_SIZE], cellYs[MAX_SIZE], cellZs[MAX_SIZE];
+		int axes[MAX_SIZE];
+		int hitIDs[MAX_SIZE];
+	};
+
+	// Gets the number of rays in a 3D ray packet for the CPU's SIMD tier.
+	int getRayPacketSize()
+	{
+		return (CPUFeatures::getTier() == CPUFeatures::Tier::AVX2) ? 8 : 4;
+	}
+
+#ifdef CPU_FEATURES_X86
+	namespace RayPacketSSE2
+	{
+		typedef SoftwareRenderer::Real3 Real3;
+
+		const int RAY_PACKET_SIZE = 4;
+
+		typedef __m128 PacketReal;
+		typedef __m128i PacketInt;
+
+		CPU_FEATURES_TARGET_SSE2
+		PacketReal packetLoad(const float *values) { return _mm_loadu_ps(values); }
+
+		CPU_FEATURES_TARGET_SSE2
+		PacketInt packetLoad(const int *values)
+		{
+			return _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+		}
+
+		CPU_FEATURES_TARGET_SSE2
+		void packetStore(int *values, PacketInt packet)
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(values), packet);
+		}
+
+		CPU_FEATURES_TARGET_SSE2
+		PacketReal packetSet(float value) { return _mm_set1_ps(value); }
+
+		CPU_FEATURES_TARGET_SSE2
+		PacketInt packetSet(int value) { return _mm_set1_epi32(value); }
+
+		CPU_FEATURES_TARGET_SSE2
+		PacketReal packetAdd(PacketReal a, PacketReal b) { return _mm_add_ps(a, b); }
+
+		CPU_FEATURES_TARGET_SSE2
+		PacketInt packetAdd(PacketInt a, PacketInt b) { return _mm_add_epi32(a, b); }
+
+		CPU_FEATURES_TARGET_SSE2
+		PacketReal packetMul(PacketReal a, PacketReal b) { return _mm_mul_ps(a, b); }
+
+		CPU_FEATURES_TARGET_SSE2
+		PacketReal packetDiv(PacketReal a, PacketReal b) { return _mm_div_ps(a, b); }
+
+		CPU_FEATURES_TARGET_SSE2
+		PacketReal packetToReal(PacketInt a) { return _mm_cvtepi32_ps(a); }
+
+		// Comparisons return a mask with all bits set in lanes where they're true.
+		CPU_FEATURES_TARGET_SSE2
+		PacketReal packetLess(PacketReal a, PacketReal b) { return _mm_cmplt_ps(a, b); }
+
+		CPU_FEATURES_TARGET_SSE2
+		PacketReal packetLess(PacketInt a, PacketInt b)
+		{
+			return _mm_castsi128_ps(_mm_cmplt_epi32(a, b));
+		}
+
+		CPU_FEATURES_TARGET_SSE2
+		PacketReal packetAnd(PacketReal a, PacketReal b) { return _mm_and_ps(a, b); }
+
+		CPU_FEATURES_TARGET_SSE2
+		PacketReal packetAndNot(PacketReal mask, PacketReal a) { return _mm_andnot_ps(mask, a); }
+
+		// Picks "a" in lanes where the mask is set and "b" elsewhere.
+		CPU_FEATURES_TARGET_SSE2
+		PacketReal packetSelect(PacketReal mask, PacketReal a, PacketReal b)
+		{
+			return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+		}
+
+		CPU_FEATURES_TARGET_SSE2
+		PacketInt packetSelect(PacketReal mask, PacketInt a, PacketInt b)
+		{
+			return _mm_castps_si128(packetSelect(mask,
+				_mm_castsi128_ps(a), _mm_castsi128_ps(b)));
+		}
+
+		// Gets one bit per lane, set where the mask is set.
+		CPU_FEATURES_TARGET_SSE2
+		int packetMaskBits(PacketReal mask) { return _mm_movemask_ps(mask); }
+
+#define RAY_PACKET_TARGET CPU_FEATURES_TARGET_SSE2
+#include "RayPacketDDA.inl"
+#undef RAY_PACKET_TARGET
+	}
+
+	namespace RayPacketAVX2
+	{
+		typedef SoftwareRenderer::Real3 Real3;
+
+		const int RAY_PACKET_SIZE = 8;
+
+		typedef __m256 PacketReal;
+		typedef __m256i PacketInt;
+
+		CPU_FEATURES_TARGET_AVX2
+		PacketReal packetLoad(const float *values) { return _mm256_loadu_ps(values); }
+
+		CPU_FEATURES_TARGET_AVX2
+		PacketInt packetLoad(const int *values)
+		{
+			return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values));
+		}
+
+		CPU_FEATURES_TARGET_AVX2
+		void packetStore(int *values, PacketInt packet)
+		{
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(values), packet);
+		}
+
+		CPU_FEATURES_TARGET_AVX2
+		PacketReal packetSet(float value) { return _mm256_set1_ps(value); }
+
+		CPU_FEATURES_TARGET_AVX2
+		PacketInt packetSet(int value) { return _mm256_set1_epi32(value); }
+
+		CPU_FEATURES_TARGET_AVX2
+		PacketReal packetAdd(PacketReal a, PacketReal b) { return _mm256_add_ps(a, b); }
+
+		CPU_FEATURES_TARGET_AVX2
+		PacketInt packetAdd(PacketInt a, PacketInt b) { return _mm256_add_epi32(a, b); }
+
+		CPU_FEATURES_TARGET_AVX2
+		PacketReal packetMul(PacketReal a, PacketReal b) { return _mm256_mul_ps(a, b); }
+
+		CPU_FEATURES_TARGET_AVX2
+		PacketReal packetDiv(PacketReal a, PacketReal b) { return _mm256_div_ps(a, b); }
+
+		CPU_FEATURES_TARGET_AVX2
+		PacketReal packetToReal(PacketInt a) { return _mm256_cvtepi32_ps(a); }
+
+		// Comparisons return a mask with all bits set in lanes where they're true.
+		CPU_FEATURES_TARGET_AVX2
+		PacketReal packetLess(PacketReal a, PacketReal b)
+		{
+			return _mm256_cmp_ps(a, b, _CMP_LT_OQ);
+		}
+
+		CPU_FEATURES_TARGET_AVX2
+		PacketReal packetLess(PacketInt a, PacketInt b)
+		{
+			return _mm256_castsi256_ps(_mm256_cmpgt_epi32(b, a));
+		}
+
+		CPU_FEATURES_TARGET_AVX2
+		PacketReal packetAnd(PacketReal a, PacketReal b) { return _mm256_and_ps(a, b); }
+
+		CPU_FEATURES_TARGET_AVX2
+		PacketReal packetAndNot(PacketReal mask, PacketReal a)
+		{
+			return _mm256_andnot_ps(mask, a);
+		}
+
+		// Picks "a" in lanes where the mask is set and "b" elsewhere.
+		CPU_FEATURES_TARGET_AVX2
+		PacketReal packetSelect(PacketReal mask, PacketReal a, PacketReal b)
+		{
+			return _mm256_blendv_ps(b, a, mask);
+		}
+
+		CPU_FEATURES_TARGET_AVX2
+		PacketInt packetSelect(PacketReal mask, PacketInt a, PacketInt b)
+		{
+			return _mm256_castps_si256(_mm256_blendv_ps(
+				_mm256_castsi256_ps(b), _mm256_castsi256_ps(a), mask));
+		}
+
+		// Gets one bit per lane, set where the mask is set.
+		CPU_FEATURES_TARGET_AVX2
+		int packetMaskBits(PacketReal mask) { return _mm256_movemask_ps(mask); }
+
+#define RAY_PACKET_TARGET CPU_FEATURES_TARGET_AVX2
+#include "RayPacketDDA.inl"
+#undef RAY_PACKET_TARGET
+	}
+#endif
+}
+
+SoftwareRenderer::SoftwareRenderer(int width, int height, int renderThreadCount,
+	bool pinRenderThreads)
+	: threadPool(renderThreadCount, pinRenderThreads)
+{
+	// One timing entry per render thread.
+	this->threadTimings = std::vector<ThreadTiming>(this->threadPool.getThreadCount());
+
+	// Initialize 2D frame buffers. Depth is only kept per column, plus one column of
+	// scratch depth for flats per render thread.
 	const int pixelCount = width * height;
 	this->colorBuffer = std::vector<uint32_t>(pixelCount);
-	this->zBuffer = std::vector<double>(pixelCount);
+	this->columnDepths = std::vector<ColumnDepth>(width);
+	this->flatDepthBuffers = std::vector<std::vector<float>>(
+		this->threadPool.getThreadCount(), std::vector<float>(height));
 	std::fill(this->colorBuffer.begin(), this->colorBuffer.end(), 0);
-	std::fill(this->zBuffer.begin(), this->zBuffer.end(), 0);
+	this->outputPixels = this->colorBuffer.data();
+	this->outputPitch = width;
+	this->renderPending = false;
 
 	this->width = width;
 	this->height = height;
-
-	// Obtain the number of threads to use. "hardware_concurrency()" might return 0,
-	// so it needs to be clamped positive.
-	this->renderThreadCount = static_cast<int>(std::thread::hardware_concurrency());
-	if (this->renderThreadCount == 0)
-	{
-		Debug::mention("Software Renderer", "hardware_concurrency() returned 0.");
-		this->renderThreadCount = 1;
-	}
+	this->full3D = false;
+	this->tiled3D = false;
+	this->indexed = false;
+
+	// Initialize per-frame values to "empty".
+	this->frameVoxelGrid = nullptr;
+	this->frameForwardComp = Real2();
+	this->frameRight2D = Real2();
+	this->frameForwardComp3D = Real3();
+	this->frameRight = Real3();
+	this->frameUp = Real3();
+	this->frameFogColor = Real3();
+	this->frameAspect = 0.0;
+	this->frameIndexed = false;
+	this->nextTile = 0;
+	this->finishedTiles = 0;
+
+	// Nothing has been drawn yet, so the first frame is drawn in full.
+	this->lastSceneState = SceneState();
+	this->dirtyColumnTiles = std::vector<bool>(
+		(width + SoftwareRenderer::COLUMN_TILE_WIDTH - 1) / SoftwareRenderer::COLUMN_TILE_WIDTH);
+	this->sceneDirty = true;
+	this->outputPaletteDirty = false;
+	this->colorBufferCurrent = false;
+	this->pendingFrameDrawn = false;
 
 	// Initialize camera values to "empty".
-	this->transform = Matrix4d();
+	this->transform = RealMatrix4();
 	this->eye = Double3();
 	this->forward = Double3();
 	this->fovY = 0.0;
@@ -41,9 +387,20 @@ SoftwareRenderer::SoftwareRenderer(int width, int height)
 	this->viewDistance = 0.0;
 	this->viewDistSquared = 0.0;
 
+	this->maxFlatHalfWidth = 0.0;
+
 	// Initialize start cell to "empty".
-	this->startCellReal = Double3();
 	this->startCell = Int3();
+	this->eyeOffset = Real3();
+
+	// The fog table is built on the first frame, once the view distance is known.
+	this->fogTable = std::vector<uint8_t>(SoftwareRenderer::FOG_LEVELS * 3 * 256);
+	this->fogColor = Double3(0.40, 0.65, 1.0);
+	this->fogLevelsPerUnit = 0.0;
+	this->fogTableDirty = true;
+
+	// Indexed rendering needs a palette first.
+	this->skyIndex = 0;
 
 	// -- test --
 	// Throw some test flats into the world.
@@ -59,7 +416,8 @@ SoftwareRenderer::SoftwareRenderer(int width, int height)
 
 SoftwareRenderer::~SoftwareRenderer()
 {
-
+	// A pipelined frame might still be using the renderer's members.
+	this->threadPool.wait();
 }
 
 const uint32_t *SoftwareRenderer::getPixels() const
@@ -67,62 +425,249 @@ const uint32_t *SoftwareRenderer::getPixels() const
 	return this->colorBuffer.data();
 }
 
+const std::vector<SoftwareRenderer::ThreadTiming> &SoftwareRenderer::getThreadTimings() const
+{
+	return this->threadTimings;
+}
+
+const SoftwareRenderer::FrameTiming &SoftwareRenderer::getFrameTiming() const
+{
+	return this->frameTiming;
+}
+
+const char *SoftwareRenderer::getPrecisionName()
+{
+#ifdef SOFTWARE_RENDERER_FLOAT
+	return "Single";
+#else
+	return "Double";
+#endif
+}
+
 void SoftwareRenderer::setEye(const Double3 &eye)
 {
+	assert(!this->renderPending);
 	this->eye = eye;
 }
 
 void SoftwareRenderer::setForward(const Double3 &forward)
 {
+	assert(!this->renderPending);
+
 	// All camera axes should be normalized.
 	this->forward = forward.normalized();
 }
 
 void SoftwareRenderer::setFovY(double fovY)
 {
+	assert(!this->renderPending);
 	this->fovY = fovY;
 }
 
 void SoftwareRenderer::setViewDistance(double viewDistance)
 {
+	assert(!this->renderPending);
+
+	// The fog table depends on view distance.
+	if (viewDistance != this->viewDistance)
+	{
+		this->fogTableDirty = true;
+	}
+
 	this->viewDistance = viewDistance;
-	this->viewDistSquared = viewDistance * viewDistance;
+	this->viewDistSquared = static_cast<Real>(viewDistance * viewDistance);
 }
 
-int SoftwareRenderer::addTexture(const uint32_t *pixels, int width, int height)
+void SoftwareRenderer::setFogColor(const Double3 &fogColor)
 {
-	const int pixelCount = width * height;
+	assert(!this->renderPending);
+	if (fogColor != this->fogColor)
+	{
+		this->fogTableDirty = true;
+	}
+
+	this->fogColor = fogColor;
+}
+
+void SoftwareRenderer::setFull3D(bool full3D)
+{
+	assert(!this->renderPending);
+	this->full3D = full3D;
+}
+
+void SoftwareRenderer::setTiled3D(bool tiled3D)
+{
+	assert(!this->renderPending);
+	this->tiled3D = tiled3D;
+}
+
+void SoftwareRenderer::setPalette(const uint32_t *colors)
+{
+	assert(!this->renderPending);
+
+	// Alpha is ignored, like in fogged texels.
+	this->palette = std::vector<uint32_t>(256);
+	for (int i = 0; i < 256; ++i)
+	{
+		this->palette[i] = colors[i] & 0x00FFFFFF;
+	}
+
+	this->outputPalette = this->palette;
+
+	for (auto &texture : this->textures)
+	{
+		this->updateTextureIndices(texture);
+	}
 
+	// The shade table and sky index depend on the palette.
+	this->fogTableDirty = true;
+	this->sceneDirty = true;
+}
+
+void SoftwareRenderer::setOutputPalette(const uint32_t *colors)
+{
+	assert(!this->renderPending);
+
+	// Frames drawn straight to colors have nothing to convert.
+	if (!this->drawsIndices())
+	{
+		return;
+	}
+
+	this->outputPalette = std::vector<uint32_t>(256);
+	for (int i = 0; i < 256; ++i)
+	{
+		this->outputPalette[i] = colors[i] & 0x00FFFFFF;
+	}
+
+	// Texels and fog keep their indices. Only the conversion to colors changes.
+	this->outputPaletteDirty = true;
+}
+
+void SoftwareRenderer::setIndexedRendering(bool indexed)
+{
+	assert(!this->renderPending);
+	if (indexed != this->indexed)
+	{
+		// The shade table is only kept up to date in indexed rendering.
+		this->fogTableDirty = true;
+		this->sceneDirty = true;
+	}
+
+	this->indexed = indexed;
+}
+
+int SoftwareRenderer::addTexture(const uint32_t *pixels, int width, int height,
+	bool mipmapped)
+{
+	assert(!this->renderPending);
+
+	// Each mip level halves the previous one's dimensions (rounded down) until both
+	// are one texel.
 	TextureData texture;
-	texture.pixels = std::vector<Double4>(pixelCount);
+	int pixelCount = 0;
+	int levelWidth = width;
+	int levelHeight = height;
+	while (true)
+	{
+		texture.levelOffsets.push_back(pixelCount);
+		pixelCount += levelWidth * levelHeight;
+
+		if (!mipmapped || ((levelWidth == 1) && (levelHeight == 1)))
+		{
+			break;
+		}
+
+		levelWidth = std::max(levelWidth / 2, 1);
+		levelHeight = std::max(levelHeight / 2, 1);
+	}
+
+	// Keep the texels in their packed ARGB format (4 bytes per pixel), so a whole
+	// set of Arena's textures (mostly 64x64) fits in the CPU cache. Shading is done
+	// with lookup tables instead of converting texels to double-precision.
+	texture.pixels = std::vector<uint32_t>(pixelCount);
 	texture.width = width;
 	texture.height = height;
 
-	// Convert ARGB color from integer to double-precision format for speed.
-	// This does waste an extreme amount of memory (32 bytes per pixel!), but
-	// it's not a big deal for Arena's textures (mostly 64x64, so eight textures
-	// would be a megabyte).
-	Double4 *texturePixels = texture.pixels.data();
-	for (int i = 0; i < pixelCount; ++i)
+	// Transpose the texels to column-major order. A screen column samples one texture
+	// column from top to bottom, so this makes each column draw a sequential read.
+	uint32_t *texturePixels = texture.pixels.data();
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			texturePixels[(x * height) + y] = pixels[x + (y * width)];
+		}
+	}
+
+	// Each texel of a mip level is the average of a 2x2 block in the level before it,
+	// so distant surfaces sample about one texel per pixel instead of skipping most
+	// of them. Odd dimensions repeat the last row or column.
+	for (int level = 1; level < static_cast<int>(texture.levelOffsets.size()); ++level)
+	{
+		const int prevWidth = std::max(width >> (level - 1), 1);
+		const int prevHeight = std::max(height >> (level - 1), 1);
+		const int levelWidth = std::max(width >> level, 1);
+		const int levelHeight = std::max(height >> level, 1);
+		const uint32_t *prevPixels = texturePixels + texture.levelOffsets[level - 1];
+		uint32_t *levelPixels = texturePixels + texture.levelOffsets[level];
+
+		for (int x = 0; x < levelWidth; ++x)
+		{
+			const int x0 = std::min(x * 2, prevWidth - 1);
+			const int x1 = std::min((x * 2) + 1, prevWidth - 1);
+			for (int y = 0; y < levelHeight; ++y)
+			{
+				const int y0 = std::min(y * 2, prevHeight - 1);
+				const int y1 = std::min((y * 2) + 1, prevHeight - 1);
+				levelPixels[(x * levelHeight) + y] = averageTexels(
+					prevPixels[(x0 * prevHeight) + y0], prevPixels[(x0 * prevHeight) + y1],
+					prevPixels[(x1 * prevHeight) + y0], prevPixels[(x1 * prevHeight) + y1]);
+			}
+		}
+	}
+
+	if (this->palette.size() > 0)
 	{
-		texturePixels[i] = Double4::fromARGB(pixels[i]);
+		this->updateTextureIndices(texture);
 	}
 
 	this->textures.push_back(std::move(texture));
 
+	// Voxels or flats might have been waiting for this texture ID.
+	this->sceneDirty = true;
+
 	return static_cast<int>(this->textures.size() - 1);
 }
 
 int SoftwareRenderer::addFlat(const Double3 &position, const Double2 &direction,
 	double width, double height, int textureID)
 {
-	// Search for the next available flat ID.
-	int id = 0;
-	while (this->flats.find(id) != this->flats.end())
+	assert(!this->renderPending);
+
+	// Reuse a free slot if there is one. Otherwise, make a new one.
+	int slotIndex;
+	if (this->freeFlatSlots.size() > 0)
+	{
+		slotIndex = this->freeFlatSlots.back();
+		this->freeFlatSlots.pop_back();
+	}
+	else
 	{
-		id++;
+		slotIndex = static_cast<int>(this->flatSlots.size());
+		Debug::check(slotIndex < (1 << SoftwareRenderer::FLAT_SLOT_BITS),
+			"Software Renderer", "Too many flats.");
+
+		FlatSlot slot;
+		slot.index = -1;
+		slot.generation = 0;
+		this->flatSlots.push_back(slot);
 	}
 
+	FlatSlot &slot = this->flatSlots[slotIndex];
+	slot.index = static_cast<int>(this->flats.size());
+	const int id = slotIndex | (slot.generation << SoftwareRenderer::FLAT_SLOT_BITS);
+
 	SoftwareRenderer::Flat flat;
 	flat.position = position;
 	flat.direction = direction;
@@ -131,7 +676,10 @@ int SoftwareRenderer::addFlat(const Double3 &position, const Double2 &direction,
 	flat.textureID = textureID;
 
 	// Add the flat (sprite, door, store sign, etc.).
-	this->flats.insert(std::make_pair(id, flat));
+	this->flats.push_back(flat);
+	this->flatIDs.push_back(id);
+	this->addFlatToChunk(id, flat);
+	this->markFlatDirty(flat);
 
 	return id;
 }
@@ -139,11 +687,24 @@ int SoftwareRenderer::addFlat(const Double3 &position, const Double2 &direction,
 void SoftwareRenderer::updateFlat(int id, const Double3 *position, const Double2 *direction,
 	const double *width, const double *height, const int *textureID)
 {
-	const auto flatIter = this->flats.find(id);
-	Debug::check(flatIter != this->flats.end(), "Software Renderer",
+	assert(!this->renderPending);
+
+	const int index = this->getFlatIndex(id);
+	Debug::check(index >= 0, "Software Renderer",
 		"Cannot update a non-existent flat (" + std::to_string(id) + ").");
 
-	SoftwareRenderer::Flat &flat = flatIter->second;
+	SoftwareRenderer::Flat &flat = this->flats[index];
+
+	// Columns that showed the flat before and after the change are drawn again.
+	this->markFlatDirty(flat);
+
+	// Take the flat out of the spatial index while its bounds change.
+	const bool boundsChanged = (position != nullptr) || (width != nullptr) ||
+		(height != nullptr);
+	if (boundsChanged)
+	{
+		this->removeFlatFromChunk(id, flat);
+	}
 
 	// Check which values requested updating and update them.
 	if (position != nullptr)
@@ -170,198 +731,782 @@ void SoftwareRenderer::updateFlat(int id, const Double3 *position, const Double2
 	{
 		flat.textureID = *textureID;
 	}
+
+	if (boundsChanged)
+	{
+		this->addFlatToChunk(id, flat);
+	}
+
+	this->markFlatDirty(flat);
 }
 
 void SoftwareRenderer::removeFlat(int id)
 {
+	assert(!this->renderPending);
+
 	// Make sure the flat exists before removing it.
-	const auto flatIter = this->flats.find(id);
-	Debug::check(flatIter != this->flats.end(), "Software Renderer",
+	const int index = this->getFlatIndex(id);
+	Debug::check(index >= 0, "Software Renderer",
 		"Cannot remove a non-existent flat (" + std::to_string(id) + ").");
 
-	this->flats.erase(flatIter);
+	this->removeFlatFromChunk(id, this->flats[index]);
+	this->markFlatDirty(this->flats[index]);
+
+	// Move the last flat into the gap so the list stays contiguous.
+	const int lastIndex = static_cast<int>(this->flats.size()) - 1;
+	if (index != lastIndex)
+	{
+		this->flats[index] = this->flats[lastIndex];
+		this->flatIDs[index] = this->flatIDs[lastIndex];
+
+		const int slotMask = (1 << SoftwareRenderer::FLAT_SLOT_BITS) - 1;
+		this->flatSlots[this->flatIDs[index] & slotMask].index = index;
+	}
+
+	this->flats.pop_back();
+	this->flatIDs.pop_back();
+
+	// Free the slot with a new generation so the old ID becomes invalid.
+	const int slotIndex = id & ((1 << SoftwareRenderer::FLAT_SLOT_BITS) - 1);
+	const int generationMask = (1 << (31 - SoftwareRenderer::FLAT_SLOT_BITS)) - 1;
+	FlatSlot &slot = this->flatSlots[slotIndex];
+	slot.index = -1;
+	slot.generation = (slot.generation + 1) & generationMask;
+	this->freeFlatSlots.push_back(slotIndex);
 }
 
 void SoftwareRenderer::resize(int width, int height)
 {
+	// The frame buffers can't change while render threads are using them.
+	assert(!this->renderPending);
+
 	const int pixelCount = width * height;
 	this->colorBuffer.resize(pixelCount);
-	this->zBuffer.resize(pixelCount);
+	this->columnDepths.resize(width);
 	std::fill(this->colorBuffer.begin(), this->colorBuffer.end(), 0);
-	std::fill(this->zBuffer.begin(), this->zBuffer.end(), 0);
+	this->outputPixels = this->colorBuffer.data();
+	this->outputPitch = width;
+
+	for (auto &flatDepths : this->flatDepthBuffers)
+	{
+		flatDepths.resize(height);
+	}
+
+	this->dirtyColumnTiles.resize(
+		(width + SoftwareRenderer::COLUMN_TILE_WIDTH - 1) / SoftwareRenderer::COLUMN_TILE_WIDTH);
+	this->sceneDirty = true;
+	this->colorBufferCurrent = false;
 
 	this->width = width;
 	this->height = height;
 }
 
-void SoftwareRenderer::updateVisibleFlats()
+uint8_t SoftwareRenderer::getNearestPaletteIndex(uint32_t color) const
 {
-	// Assumes that "visibleFlats" is empty.
-	for (const auto &pair : this->flats)
+	const int r = static_cast<int>((color >> 16) & 0xFF);
+	const int g = static_cast<int>((color >> 8) & 0xFF);
+	const int b = static_cast<int>(color & 0xFF);
+
+	// Squared distance in RGB. The first of any duplicate colors is used.
+	int nearestIndex = 0;
+	int nearestDistance = std::numeric_limits<int>::max();
+	for (int i = 0; i < 256; ++i)
 	{
-		const Flat &flat = pair.second;
+		const uint32_t paletteColor = this->palette[i];
+		const int dr = static_cast<int>((paletteColor >> 16) & 0xFF) - r;
+		const int dg = static_cast<int>((paletteColor >> 8) & 0xFF) - g;
+		const int db = static_cast<int>(paletteColor & 0xFF) - b;
+		const int distance = (dr * dr) + (dg * dg) + (db * db);
+		if (distance < nearestDistance)
+		{
+			nearestIndex = i;
+			nearestDistance = distance;
 
-		// Get the flat's axes. (0, 1, 0) is "global up".
-		const Double3 flatForward = Double3(flat.direction.x, 0.0, flat.direction.y).normalized();
-		const Double3 flatUp(0.0, 1.0, 0.0);
-		const Double3 flatRight = flatForward.cross(flatUp).normalized();
+			if (distance == 0)
+			{
+				break;
+			}
+		}
+	}
 
-		const Double3 flatRightScaled = flatRight * (flat.width * 0.50);
-		const Double3 flatUpScaled = flatUp * flat.height;
+	return static_cast<uint8_t>(nearestIndex);
+}
 
-		// Calculate the four corners of the flat in world space.
-		const Double3 topLeft = flat.position - flatRightScaled + flatUpScaled;
-		const Double3 topRight = flat.position + flatRightScaled + flatUpScaled;
-		const Double3 bottomLeft = flat.position - flatRightScaled;
-		const Double3 bottomRight = flat.position + flatRightScaled;
+void SoftwareRenderer::updateTextureIndices(TextureData &texture) const
+{
+	// Level 0 texels usually came from the same palette, so most are exact matches.
+	// Averaged mip texels get the nearest color.
+	std::unordered_map<uint32_t, uint8_t> nearestIndices;
+	texture.indices = std::vector<uint8_t>(texture.pixels.size());
+	for (size_t i = 0; i < texture.pixels.size(); ++i)
+	{
+		const uint32_t color = texture.pixels[i] & 0x00FFFFFF;
+		const auto iter = nearestIndices.find(color);
+		if (iter != nearestIndices.end())
+		{
+			texture.indices[i] = iter->second;
+		}
+		else
+		{
+			const uint8_t index = this->getNearestPaletteIndex(color);
+			nearestIndices.insert(std::make_pair(color, index));
+			texture.indices[i] = index;
+		}
+	}
+}
 
-		// Transform the points to camera space (projection * view).
-		Double4 p1 = this->transform * Double4(topLeft.x, topLeft.y, topLeft.z, 1.0);
-		Double4 p2 = this->transform * Double4(topRight.x, topRight.y, topRight.z, 1.0);
-		Double4 p3 = this->transform * Double4(bottomLeft.x, bottomLeft.y, bottomLeft.z, 1.0);
-		Double4 p4 = this->transform * Double4(bottomRight.x, bottomRight.y, bottomRight.z, 1.0);
+void SoftwareRenderer::updateFogTable()
+{
+	// Precompute each color channel value blended with the fog color at evenly spaced
+	// distances up to the view distance, so fogging a texel is a distance scale and
+	// three table lookups instead of double math.
+	for (int level = 0; level < SoftwareRenderer::FOG_LEVELS; ++level)
+	{
+		const double fogPercent = static_cast<double>(level) /
+			static_cast<double>(SoftwareRenderer::FOG_LEVELS - 1);
+		uint8_t *fogRow = this->fogTable.data() + (level * 3 * 256);
 
-		// Create fresh projection data for the flat by projecting the points to the 
-		// viewing plane. Also take camera elevation into account.
-		Flat::ProjectionData projectionData;
-		const double cameraElevation = this->forward.y;
+		for (int value = 0; value < 256; ++value)
+		{
+			const double valueReal = static_cast<double>(value) / 255.0;
+			const Double3 color = Double3(valueReal, valueReal, valueReal)
+				.lerp(this->fogColor, fogPercent).clamped();
+			fogRow[value] = static_cast<uint8_t>(color.x * 255.0);
+			fogRow[256 + value] = static_cast<uint8_t>(color.y * 255.0);
+			fogRow[512 + value] = static_cast<uint8_t>(color.z * 255.0);
+		}
+	}
 
-		// Get Z distances.
-		projectionData.leftZ = p1.z;
-		projectionData.rightZ = p2.z;
+	// Indexed rendering uses a shade table like Arena's instead: each palette index
+	// fogged with the fog table, then matched back to the palette. Many fogged colors
+	// repeat between levels, so matches are reused.
+	if (this->indexed && (this->palette.size() > 0))
+	{
+		std::unordered_map<uint32_t, uint8_t> nearestIndices;
+		auto getNearestIndex = [this, &nearestIndices](uint32_t color)
+		{
+			const auto iter = nearestIndices.find(color);
+			if (iter != nearestIndices.end())
+			{
+				return iter->second;
+			}
 
-		// Convert to normalized coordinates.
-		p1 = p1 / p1.w;
-		p2 = p2 / p2.w;
-		p3 = p3 / p3.w;
-		p4 = p4 / p4.w;
-
-		// Translate coordinates on the screen relative to the middle (0.5, 0.5).
-		// Multiply by 0.5 to apply the correct aspect ratio.
-		projectionData.leftX = 0.50 + (p1.x * 0.50);
-		projectionData.rightX = 0.50 + (p2.x * 0.50);
-		projectionData.topLeftY = (0.50 + cameraElevation) - (p1.y * 0.50);
-		projectionData.topRightY = (0.50 + cameraElevation) - (p2.y * 0.50);
-		projectionData.bottomLeftY = (0.50 + cameraElevation) - (p3.y * 0.50);
-		projectionData.bottomRightY = (0.50 + cameraElevation) - (p4.y * 0.50);
-
-		// The flat is visible if at least one of the Z values is positive and
-		// the vertical edges are within bounds.
-		const bool leftZPositive = projectionData.leftZ > 0.0;
-		const bool rightZPositive = projectionData.rightZ > 0.0;
-		const bool rightEdgeVisible =
-			(projectionData.rightX >= 0.0) || (projectionData.rightX < 1.0) &&
-			((projectionData.topRightY < 1.0) || (projectionData.bottomRightY >= 0.0));
-		const bool leftEdgeVisible =
-			(projectionData.leftX >= 0.0) || (projectionData.leftX < 1.0) &&
-			((projectionData.topLeftY < 1.0) || (projectionData.bottomLeftY >= 0.0));
-
-		// - To do: make this code more correct. It should not reject points
-		//   when an edge is visible (i.e., top is above screen, bottom is below screen).
-		// - I also think some more robust rasterization practices might need to be included,
-		//   so that flats intersecting the viewing plane are rendered correctly. For example,
-		//   clipping anything with negative Z and interpolating the new texture coordinates...? 
-		//   Just an idea. Right now it throws away flats partially behind the view plane.
-		if ((leftZPositive && rightZPositive) && (rightEdgeVisible || leftEdgeVisible))
-		{
-			this->visibleFlats.push_back(std::make_pair(&flat, projectionData));
-		}
-	}
-}
-
-Double3 SoftwareRenderer::castRay(const Double3 &direction,
-	const VoxelGrid &voxelGrid) const
+			const uint8_t index = this->getNearestPaletteIndex(color);
+			nearestIndices.insert(std::make_pair(color, index));
+			return index;
+		};
+
+		this->shadeTable.resize(SoftwareRenderer::FOG_LEVELS * 256);
+		for (int level = 0; level < SoftwareRenderer::FOG_LEVELS; ++level)
+		{
+			const uint8_t *fogRow = this->fogTable.data() + (level * 3 * 256);
+			uint8_t *shadeRow = this->shadeTable.data() + (level * 256);
+			for (int i = 0; i < 256; ++i)
+			{
+				shadeRow[i] = getNearestIndex(applyFog(this->palette[i], fogRow));
+			}
+		}
+
+		this->skyIndex = getNearestIndex(this->fogColor.toRGB());
+	}
+
+	this->fogLevelsPerUnit = static_cast<Real>(
+		static_cast<double>(SoftwareRenderer::FOG_LEVELS - 1) / this->viewDistance);
+	this->fogTableDirty = false;
+}
+
+int SoftwareRenderer::getFogLevel(Real distance) const
 {
-	// This is an extension of Lode Vandevenne's DDA algorithm from 2D to 3D.
-	// Technically, it could be considered a "3D-DDA" algorithm. It will eventually 
-	// have some additional features so all of Arena's geometry can be represented.
+	// Anything past the view distance is fully fogged.
+	const int level = static_cast<int>(std::round(distance * this->fogLevelsPerUnit));
+	return std::max(0, std::min(level, SoftwareRenderer::FOG_LEVELS - 1));
+}
 
-	// To do:
-	// - Figure out proper DDA lengths for variable-height voxels, and why using
-	//   voxelHeight squared instead of 1.0 in deltaDist.y looks weird (sideDist.y?).
-	// - Cuboids within voxels (bridges, beds, shelves) with variable Y offset and size.
-	// - Sprites (SpriteGrid? Sprite data, and list of sprite IDs per voxel).
-	// - Transparent textures (check texel alpha in DDA loop).
-	// - Sky (if hitID == 0).
-	// - Shading (shadows from the sun, point lights).
+const uint8_t *SoftwareRenderer::getFogTableRow(Real distance) const
+{
+	return this->fogTable.data() + (this->getFogLevel(distance) * 3 * 256);
+}
 
-	// Some floating point behavior assumptions:
-	// -> (value / 0.0) == infinity
-	// -> (value / infinity) == 0.0
-	// -> (int)(-0.8) == 0
-	// -> (int)floor(-0.8) == -1
-	// -> (int)ceil(-0.8) == 0
+const uint8_t *SoftwareRenderer::getShadeTableRow(Real distance) const
+{
+	return this->shadeTable.data() + (this->getFogLevel(distance) * 256);
+}
+
+int SoftwareRenderer::getMipLevel(const TextureData &texture, Real texelsPerPixel)
+{
+	// Largest level that still has at least one texel per pixel.
+	const int levelCount = static_cast<int>(texture.levelOffsets.size());
+	int level = 0;
+	while (((level + 1) < levelCount) && (texelsPerPixel >= static_cast<Real>(2.0)))
+	{
+		texelsPerPixel *= static_cast<Real>(0.50);
+		level++;
+	}
+
+	return level;
+}
+
+int SoftwareRenderer::getFlatIndex(int id) const
+{
+	if (id < 0)
+	{
+		return -1;
+	}
+
+	const int slotIndex = id & ((1 << SoftwareRenderer::FLAT_SLOT_BITS) - 1);
+	const int generation = id >> SoftwareRenderer::FLAT_SLOT_BITS;
+	if (slotIndex >= static_cast<int>(this->flatSlots.size()))
+	{
+		return -1;
+	}
+
+	// Free slots have an index of -1.
+	const FlatSlot &slot = this->flatSlots[slotIndex];
+	return (slot.generation == generation) ? slot.index : -1;
+}
+
+Int2 SoftwareRenderer::getFlatChunkCoord(const Double3 &position)
+{
+	const double chunkSizeReal = static_cast<double>(SoftwareRenderer::FLAT_CHUNK_SIZE);
+	return Int2(
+		static_cast<int>(std::floor(position.x / chunkSizeReal)),
+		static_cast<int>(std::floor(position.z / chunkSizeReal)));
+}
+
+void SoftwareRenderer::addFlatToChunk(int id, const Flat &flat)
+{
+	const double halfWidth = flat.width * 0.50;
+	const double topY = flat.position.y + flat.height;
+	const Int2 coord = SoftwareRenderer::getFlatChunkCoord(flat.position);
+
+	auto chunkIter = this->flatChunks.find(coord);
+	if (chunkIter == this->flatChunks.end())
+	{
+		FlatChunk chunk;
+		chunk.minY = std::min(flat.position.y, topY);
+		chunk.maxY = std::max(flat.position.y, topY);
+		chunk.maxHalfWidth = halfWidth;
+		chunkIter = this->flatChunks.insert(std::make_pair(coord, chunk)).first;
+	}
+	else
+	{
+		FlatChunk &chunk = chunkIter->second;
+		chunk.minY = std::min(chunk.minY, std::min(flat.position.y, topY));
+		chunk.maxY = std::max(chunk.maxY, std::max(flat.position.y, topY));
+		chunk.maxHalfWidth = std::max(chunk.maxHalfWidth, halfWidth);
+	}
+
+	chunkIter->second.flatIDs.push_back(id);
+	this->maxFlatHalfWidth = std::max(this->maxFlatHalfWidth, halfWidth);
+}
+
+void SoftwareRenderer::removeFlatFromChunk(int id, const Flat &flat)
+{
+	const Int2 coord = SoftwareRenderer::getFlatChunkCoord(flat.position);
+	const auto chunkIter = this->flatChunks.find(coord);
+	assert(chunkIter != this->flatChunks.end());
+
+	// Chunks only hold a handful of flats, so a linear search is fine. Order within
+	// a chunk doesn't matter.
+	std::vector<int> &flatIDs = chunkIter->second.flatIDs;
+	const auto idIter = std::find(flatIDs.begin(), flatIDs.end(), id);
+	assert(idIter != flatIDs.end());
+	*idIter = flatIDs.back();
+	flatIDs.pop_back();
+
+	// Free empty chunks so their bounds are reset if reused.
+	if (flatIDs.empty())
+	{
+		this->flatChunks.erase(chunkIter);
+	}
+}
+
+bool SoftwareRenderer::flatChunkIsVisible(const Int2 &coord, const FlatChunk &chunk) const
+{
+	// Bounding box of everything the chunk's flats can cover.
+	const double chunkSizeReal = static_cast<double>(SoftwareRenderer::FLAT_CHUNK_SIZE);
+	const double minX = (static_cast<double>(coord.x) * chunkSizeReal) - chunk.maxHalfWidth;
+	const double maxX = (static_cast<double>(coord.x + 1) * chunkSizeReal) + chunk.maxHalfWidth;
+	const double minZ = (static_cast<double>(coord.y) * chunkSizeReal) - chunk.maxHalfWidth;
+	const double maxZ = (static_cast<double>(coord.y + 1) * chunkSizeReal) + chunk.maxHalfWidth;
+
+	// Y-shearing moves the visible range of normalized Y coordinates.
+	const double cameraElevation = this->forward.y;
+	const double topNormalizedY = (2.0 * cameraElevation) + 1.0;
+	const double bottomNormalizedY = (2.0 * cameraElevation) - 1.0;
+
+	// The box is invisible if all eight corners are on the outer side of one frustum 
+	// plane. The far plane is at the view distance, and anything past it would be 
+	// drawn entirely with fog color anyway.
+	int leftCount = 0, rightCount = 0, topCount = 0, bottomCount = 0;
+	int behindCount = 0, farCount = 0;
+	for (int i = 0; i < 8; ++i)
+	{
+		const Double3 corner(
+			((i & 1) != 0) ? maxX : minX,
+			((i & 2) != 0) ? chunk.maxY : chunk.minY,
+			((i & 4) != 0) ? maxZ : minZ);
+		const Real4 p = this->transformPoint(corner);
+
+		leftCount += (p.x < -p.w) ? 1 : 0;
+		rightCount += (p.x > p.w) ? 1 : 0;
+		topCount += (p.y > (topNormalizedY * p.w)) ? 1 : 0;
+		bottomCount += (p.y < (bottomNormalizedY * p.w)) ? 1 : 0;
+		behindCount += (p.w <= 0.0) ? 1 : 0;
+		farCount += (p.z >= this->viewDistance) ? 1 : 0;
+	}
+
+	return (leftCount < 8) && (rightCount < 8) && (topCount < 8) &&
+		(bottomCount < 8) && (behindCount < 8) && (farCount < 8);
+}
+
+void SoftwareRenderer::updateVisibleFlats()
+{
+	// Find the range of chunks that could be inside the viewing frustum. The farthest 
+	// point in the frustum is a corner of the far plane, and Y-shearing stretches 
+	// the frustum vertically.
+	const double aspect = static_cast<double>(this->width) /
+		static_cast<double>(this->height);
+	const double zoom = 1.0 / std::tan((this->fovY * 0.5) * DEG_TO_RAD);
+	const double frustumHalfWidth = aspect / zoom;
+	const double frustumHalfHeight = (1.0 + (2.0 * std::abs(this->forward.y))) / zoom;
+	const double frustumRadius = (this->viewDistance * std::sqrt(1.0 +
+		(frustumHalfWidth * frustumHalfWidth) + (frustumHalfHeight * frustumHalfHeight))) +
+		this->maxFlatHalfWidth;
+
+	const Int2 minChunk = SoftwareRenderer::getFlatChunkCoord(Double3(
+		this->eye.x - frustumRadius, 0.0, this->eye.z - frustumRadius));
+	const Int2 maxChunk = SoftwareRenderer::getFlatChunkCoord(Double3(
+		this->eye.x + frustumRadius, 0.0, this->eye.z + frustumRadius));
+
+	// Assumes that "visibleFlats" is empty.
+	for (int chunkZ = minChunk.y; chunkZ <= maxChunk.y; ++chunkZ)
+	{
+		for (int chunkX = minChunk.x; chunkX <= maxChunk.x; ++chunkX)
+		{
+			const Int2 coord(chunkX, chunkZ);
+			const auto chunkIter = this->flatChunks.find(coord);
+			if ((chunkIter == this->flatChunks.end()) ||
+				!this->flatChunkIsVisible(coord, chunkIter->second))
+			{
+				continue;
+			}
+
+			for (const int id : chunkIter->second.flatIDs)
+			{
+				this->addVisibleFlat(this->flats[this->getFlatIndex(id)]);
+			}
+		}
+	}
+}
+
+SoftwareRenderer::Real4 SoftwareRenderer::transformPoint(const Double3 &point) const
+{
+	// The transform has no translation, so large world coordinates don't have to be
+	// represented in the renderer's precision.
+	const Double3 relativePoint = point - this->eye;
+	return this->transform * Real4(static_cast<Real>(relativePoint.x),
+		static_cast<Real>(relativePoint.y), static_cast<Real>(relativePoint.z),
+		static_cast<Real>(1.0));
+}
+
+bool SoftwareRenderer::projectFlat(const Flat &flat,
+	Flat::ProjectionData &projectionData) const
+{
+	// Get the flat's axes. (0, 1, 0) is "global up".
+	const Double3 flatForward = Double3(flat.direction.x, 0.0, flat.direction.y).normalized();
+	const Double3 flatUp(0.0, 1.0, 0.0);
+	const Double3 flatRight = flatForward.cross(flatUp).normalized();
+
+	const Double3 flatRightScaled = flatRight * (flat.width * 0.50);
+	const Double3 flatUpScaled = flatUp * flat.height;
+
+	// Calculate the four corners of the flat in world space.
+	const Double3 topLeft = flat.position - flatRightScaled + flatUpScaled;
+	const Double3 topRight = flat.position + flatRightScaled + flatUpScaled;
+	const Double3 bottomLeft = flat.position - flatRightScaled;
+	const Double3 bottomRight = flat.position + flatRightScaled;
+
+	// Transform the points to camera space (projection * view).
+	Real4 p1 = this->transformPoint(topLeft);
+	Real4 p2 = this->transformPoint(topRight);
+	Real4 p3 = this->transformPoint(bottomLeft);
+	Real4 p4 = this->transformPoint(bottomRight);
+
+	// Create fresh projection data for the flat by projecting the points to the 
+	// viewing plane. Also take camera elevation into account.
+	const Real cameraElevation = static_cast<Real>(this->forward.y);
+	const Real half = static_cast<Real>(0.50);
+
+	// Get Z distances.
+	projectionData.leftZ = p1.z;
+	projectionData.rightZ = p2.z;
+
+	// Convert to normalized coordinates.
+	p1 = p1 / p1.w;
+	p2 = p2 / p2.w;
+	p3 = p3 / p3.w;
+	p4 = p4 / p4.w;
+
+	// Translate coordinates on the screen relative to the middle (0.5, 0.5).
+	// Multiply by 0.5 to apply the correct aspect ratio.
+	projectionData.leftX = half + (p1.x * half);
+	projectionData.rightX = half + (p2.x * half);
+	projectionData.topLeftY = (half + cameraElevation) - (p1.y * half);
+	projectionData.topRightY = (half + cameraElevation) - (p2.y * half);
+	projectionData.bottomLeftY = (half + cameraElevation) - (p3.y * half);
+	projectionData.bottomRightY = (half + cameraElevation) - (p4.y * half);
+
+	// The flat is visible if at least one of the Z values is positive and
+	// the vertical edges are within bounds.
+	const bool leftZPositive = projectionData.leftZ > 0.0;
+	const bool rightZPositive = projectionData.rightZ > 0.0;
+	const bool rightEdgeVisible =
+		(projectionData.rightX >= 0.0) || (projectionData.rightX < 1.0) &&
+		((projectionData.topRightY < 1.0) || (projectionData.bottomRightY >= 0.0));
+	const bool leftEdgeVisible =
+		(projectionData.leftX >= 0.0) || (projectionData.leftX < 1.0) &&
+		((projectionData.topLeftY < 1.0) || (projectionData.bottomLeftY >= 0.0));
+
+	// - To do: make this code more correct. It should not reject points
+	//   when an edge is visible (i.e., top is above screen, bottom is below screen).
+	// - I also think some more robust rasterization practices might need to be included,
+	//   so that flats intersecting the viewing plane are rendered correctly. For example,
+	//   clipping anything with negative Z and interpolating the new texture coordinates...? 
+	//   Just an idea. Right now it throws away flats partially behind the view plane.
+	return (leftZPositive && rightZPositive) && (rightEdgeVisible || leftEdgeVisible);
+}
+
+void SoftwareRenderer::getFlatColumnTiles(const Flat::ProjectionData &projectionData,
+	int &startTile, int &endTile) const
+{
+	// Screen columns the flat might touch. One column of padding on each side covers
+	// rounding, since each column does an exact test later. The X values are clamped
+	// first so huge values don't overflow when cast.
+	const double widthReal = static_cast<double>(this->width);
+	const double minX = std::min(projectionData.leftX, projectionData.rightX);
+	const double maxX = std::max(projectionData.leftX, projectionData.rightX);
+	const int startX = std::max(0, static_cast<int>(
+		std::floor(std::max(minX, -1.0) * widthReal)) - 1);
+	const int endX = std::min(this->width - 1, static_cast<int>(
+		std::floor(std::min(maxX, 2.0) * widthReal)) + 1);
+
+	startTile = startX / SoftwareRenderer::COLUMN_TILE_WIDTH;
+	endTile = endX / SoftwareRenderer::COLUMN_TILE_WIDTH;
+}
+
+void SoftwareRenderer::markFlatDirty(const Flat &flat)
+{
+	// Before the first frame (or after a resize), everything is drawn anyway.
+	if (this->sceneDirty)
+	{
+		return;
+	}
+
+	Flat::ProjectionData projectionData;
+	if (this->projectFlat(flat, projectionData))
+	{
+		int startTile, endTile;
+		this->getFlatColumnTiles(projectionData, startTile, endTile);
+		for (int tile = startTile; tile <= endTile; ++tile)
+		{
+			this->dirtyColumnTiles[tile] = true;
+		}
+	}
+}
+
+void SoftwareRenderer::addVisibleFlat(const Flat &flat)
+{
+	Flat::ProjectionData projectionData;
+	if (this->projectFlat(flat, projectionData))
+	{
+		this->visibleFlats.push_back(std::make_pair(&flat, projectionData));
+	}
+}
+
+void SoftwareRenderer::binVisibleFlats()
+{
+	const int tileCount = (this->width + SoftwareRenderer::COLUMN_TILE_WIDTH - 1) /
+		SoftwareRenderer::COLUMN_TILE_WIDTH;
+
+	// Keep each bin's allocation between frames.
+	this->visibleFlatBins.resize(tileCount);
+	for (auto &bin : this->visibleFlatBins)
+	{
+		bin.clear();
+	}
+
+	for (size_t i = 0; i < this->visibleFlats.size(); ++i)
+	{
+		int startTile, endTile;
+		this->getFlatColumnTiles(this->visibleFlats[i].second, startTile, endTile);
+		for (int tile = startTile; tile <= endTile; ++tile)
+		{
+			this->visibleFlatBins[tile].push_back(static_cast<int>(i));
+		}
+	}
+}
 
-	const Double3 dirSquared(
+SoftwareRenderer::RayStart SoftwareRenderer::getRayStart(const Real3 &direction,
+	Real voxelHeight) const
+{
+	const Real3 dirSquared(
 		direction.x * direction.x,
 		direction.y * direction.y,
 		direction.z * direction.z);
 
-	// Height (Y size) of each voxel in the voxel grid. Some levels in Arena have
-	// "tall" voxels, so the voxel height must be a variable.
-	const double voxelHeight = voxelGrid.getVoxelHeight();
-
-	// A custom variable that represents the Y "floor" of the current voxel.
-	const double eyeYRelativeFloor = std::floor(this->eye.y / voxelHeight) * voxelHeight;
+	RayStart start;
 
 	// Calculate delta distances along each axis. These determine how far
 	// the ray has to go until the next X, Y, or Z side is hit, respectively.
-	const Double3 deltaDist(
-		std::sqrt(1.0 + (dirSquared.y / dirSquared.x) + (dirSquared.z / dirSquared.x)),
-		std::sqrt(1.0 + (dirSquared.x / dirSquared.y) + (dirSquared.z / dirSquared.y)),
-		std::sqrt(1.0 + (dirSquared.x / dirSquared.z) + (dirSquared.y / dirSquared.z)));
+	const Real one = static_cast<Real>(1.0);
+	start.deltaDist = Real3(
+		std::sqrt(one + (dirSquared.y / dirSquared.x) + (dirSquared.z / dirSquared.x)),
+		std::sqrt(one + (dirSquared.x / dirSquared.y) + (dirSquared.z / dirSquared.y)),
+		std::sqrt(one + (dirSquared.x / dirSquared.z) + (dirSquared.y / dirSquared.z)));
+
+	// Calculate step directions and initial side distances from where the eye is
+	// within its voxel.
+	if (direction.x >= 0.0)
+	{
+		start.step.x = 1;
+		start.sideDist.x = (one - this->eyeOffset.x) * start.deltaDist.x;
+	}
+	else
+	{
+		start.step.x = -1;
+		start.sideDist.x = this->eyeOffset.x * start.deltaDist.x;
+	}
+
+	if (direction.y >= 0.0)
+	{
+		start.step.y = 1;
+		start.sideDist.y = (voxelHeight - this->eyeOffset.y) * start.deltaDist.y;
+	}
+	else
+	{
+		start.step.y = -1;
+		start.sideDist.y = this->eyeOffset.y * start.deltaDist.y;
+	}
 
-	// Booleans for whether a ray component is non-negative. Used with step directions 
+	if (direction.z >= 0.0)
+	{
+		start.step.z = 1;
+		start.sideDist.z = (one - this->eyeOffset.z) * start.deltaDist.z;
+	}
+	else
+	{
+		start.step.z = -1;
+		start.sideDist.z = this->eyeOffset.z * start.deltaDist.z;
+	}
+
+	return start;
+}
+
+SoftwareRenderer::Real3 SoftwareRenderer::getRayColor(const Real3 &direction,
+	const Int3 &cell, FaceAxis axis, char hitID, const VoxelGrid &voxelGrid) const
+{
+	// No intersection. Return sky color.
+	if (hitID <= 0)
+	{
+		return this->frameFogColor;
+	}
+
+	const Real voxelHeight = static_cast<Real>(voxelGrid.getVoxelHeight());
+	const Real one = static_cast<Real>(1.0);
+	const Real two = static_cast<Real>(2.0);
+
+	// Booleans for whether a ray component is non-negative. Used with step directions
 	// and texture coordinates.
 	const bool nonNegativeDirX = direction.x >= 0.0;
 	const bool nonNegativeDirY = direction.y >= 0.0;
 	const bool nonNegativeDirZ = direction.z >= 0.0;
 
-	// Calculate step directions and initial side distances.
-	Int3 step;
-	Double3 sideDist;
-	if (nonNegativeDirX)
+	// Step magnitudes as reals.
+	const Real3 stepReal(
+		nonNegativeDirX ? one : -one,
+		nonNegativeDirY ? one : -one,
+		nonNegativeDirZ ? one : -one);
+
+	// Boolean for whether the ray ended in the same voxel it started in.
+	const bool stoppedInFirstVoxel = cell == this->startCell;
+
+	// Get the distance from the camera to the hit point. It is a special case
+	// if the ray stopped in the first voxel, using the initial side distances.
+	Real distance;
+	if (stoppedInFirstVoxel)
 	{
-		step.x = 1;
-		sideDist.x = (this->startCellReal.x + 1.0 - this->eye.x) * deltaDist.x;
+		const Real3 initialSideDist = this->getRayStart(direction, voxelHeight).sideDist;
+		if ((initialSideDist.x < initialSideDist.y) &&
+			(initialSideDist.x < initialSideDist.z))
+		{
+			distance = initialSideDist.x;
+			axis = FaceAxis::X;
+		}
+		else if (initialSideDist.y < initialSideDist.z)
+		{
+			distance = initialSideDist.y;
+			axis = FaceAxis::Y;
+		}
+		else
+		{
+			distance = initialSideDist.z;
+			axis = FaceAxis::Z;
+		}
 	}
 	else
 	{
-		step.x = -1;
-		sideDist.x = (this->eye.x - this->startCellReal.x) * deltaDist.x;
+		// Assign to distance based on which axis was hit. Cells are relative to the
+		// start voxel like the eye offset.
+		if (axis == FaceAxis::X)
+		{
+			distance = (static_cast<Real>(cell.x - this->startCell.x) - this->eyeOffset.x +
+				((one - stepReal.x) / two)) / direction.x;
+		}
+		else if (axis == FaceAxis::Y)
+		{
+			distance = ((static_cast<Real>(cell.y - this->startCell.y) * voxelHeight) -
+				this->eyeOffset.y + (((one - stepReal.y) / two) * voxelHeight)) / direction.y;
+		}
+		else
+		{
+			distance = (static_cast<Real>(cell.z - this->startCell.z) - this->eyeOffset.z +
+				((one - stepReal.z) / two)) / direction.z;
+		}
 	}
 
-	if (nonNegativeDirY)
+	// Intersection point on the voxel, relative to the start voxel. Texture coordinates
+	// only depend on the hit point's place within a voxel.
+	const Real3 hitPoint = this->eyeOffset + (direction * distance);
+
+	// Boolean for whether the hit point is on the back of a voxel face.
+	const bool backFace = stoppedInFirstVoxel;
+
+	// Texture coordinates. U and V are affected by which side is hit (near, far),
+	// and whether the hit point is on the front or back of the voxel face.
+	// - Note, for edge cases where {u,v}Val == 1.0, the texture coordinate is
+	//   out of bounds by one pixel, so instead of 1.0, something like 0.9999999
+	//   should be used instead. std::nextafter(1.0, -INFINITY)?
+	// - The hit point can be below the start voxel, so Y is wrapped into a voxel with
+	//   std::floor() instead of std::fmod().
+	Real u, v;
+	if (axis == FaceAxis::X)
 	{
-		step.y = 1;
-		sideDist.y = (eyeYRelativeFloor + voxelHeight - this->eye.y) * deltaDist.y;
+		const Real uVal = hitPoint.z - std::floor(hitPoint.z);
+		const Real yVal = hitPoint.y - (std::floor(hitPoint.y / voxelHeight) * voxelHeight);
+
+		u = (nonNegativeDirX ^ backFace) ? uVal : (one - uVal);
+		//v = 1.0 - (hitPoint.y - std::floor(hitPoint.y));
+		v = one - (yVal / voxelHeight);
 	}
-	else
+	else if (axis == FaceAxis::Y)
 	{
-		step.y = -1;
-		sideDist.y = (this->eye.y - eyeYRelativeFloor) * deltaDist.y;
-	}
+		const Real vVal = hitPoint.x - std::floor(hitPoint.x);
 
-	if (nonNegativeDirZ)
-	{
-		step.z = 1;
-		sideDist.z = (this->startCellReal.z + 1.0 - this->eye.z) * deltaDist.z;
+		u = hitPoint.z - std::floor(hitPoint.z);
+		v = (nonNegativeDirY ^ backFace) ? vVal : (one - vVal);
 	}
 	else
 	{
-		step.z = -1;
-		sideDist.z = (this->eye.z - this->startCellReal.z) * deltaDist.z;
+		const Real uVal = hitPoint.x - std::floor(hitPoint.x);
+		const Real yVal = hitPoint.y - (std::floor(hitPoint.y / voxelHeight) * voxelHeight);
+
+		u = (nonNegativeDirZ ^ backFace) ? (one - uVal) : uVal;
+		//v = 1.0 - (hitPoint.y - std::floor(hitPoint.y));
+		v = one - (yVal / voxelHeight);
+	}
+
+	// -- temp --
+	// Display bad texture coordinates as magenta. If any of these is true, it
+	// means something above is wrong. The comparisons are written so NaN (i.e.,
+	// from a ray exactly along an axis) is caught too.
+	if (!((u >= 0.0) && (u < 1.0) && (v >= 0.0) && (v < 1.0)))
+	{
+		return Real3(one, static_cast<Real>(0.0), one);
 	}
+	// -- end temp --
+
+	// Get the voxel data associated with the ID. Subtract 1 because the first
+	// entry is at index 0 but the lowest hitID is 1.
+	const VoxelData &voxelData = voxelGrid.getVoxelData(hitID - 1);
+
+	// Get the texture depending on which face was hit.
+	const TextureData &texture = (axis == FaceAxis::Y) ?
+		this->textures[voxelData.floorAndCeilingID] :
+		this->textures[voxelData.sideID];
+
+	// Calculate position in texture.
+	const int textureX = static_cast<int>(u * texture.width);
+	const int textureY = static_cast<int>(v * texture.height);
+
+	// Get the texel color at the hit point.
+	// - Later, the alpha component can be used for transparency and ignoring
+	//   intersections (in the DDA loop).
+	const uint32_t texel = texture.pixels[(textureX * texture.height) + textureY];
+
+	// Convert the texel to a 3-component color.
+	const Real3 color = Real3::fromRGB(texel);
+
+	// Linearly interpolate with some depth.
+	const Real viewDistance = static_cast<Real>(this->viewDistance);
+	const Real depth = std::min(distance, viewDistance) / viewDistance;
+	return color.lerp(this->frameFogColor, depth);
+}
+
+SoftwareRenderer::Real3 SoftwareRenderer::castRay(const Real3 &direction,
+	const VoxelGrid &voxelGrid) const
+{
+	// This is an extension of Lode Vandevenne's DDA algorithm from 2D to 3D.
+	// Technically, it could be considered a "3D-DDA" algorithm. It will eventually 
+	// have some additional features so all of Arena's geometry can be represented.
 
-	// Make a copy of the initial side distances. They are used for the special case 
-	// of the ray ending in the same voxel it started in.
-	const Double3 initialSideDist = sideDist;
+	// To do:
+	// - Figure out proper DDA lengths for variable-height voxels, and why using
+	//   voxelHeight squared instead of 1.0 in deltaDist.y looks weird (sideDist.y?).
+	// - Cuboids within voxels (bridges, beds, shelves) with variable Y offset and size.
+	// - Sprites (SpriteGrid? Sprite data, and list of sprite IDs per voxel).
+	// - Transparent textures (check texel alpha in DDA loop).
+	// - Sky (if hitID == 0).
+	// - Shading (shadows from the sun, point lights).
+
+	// Some floating point behavior assumptions:
+	// -> (value / 0.0) == infinity
+	// -> (value / infinity) == 0.0
+	// -> (int)(-0.8) == 0
+	// -> (int)floor(-0.8) == -1
+	// -> (int)ceil(-0.8) == 0
+
+	// Height (Y size) of each voxel in the voxel grid. Some levels in Arena have
+	// "tall" voxels, so the voxel height must be a variable.
+	const Real voxelHeight = static_cast<Real>(voxelGrid.getVoxelHeight());
+	const Real one = static_cast<Real>(1.0);
+	const Real two = static_cast<Real>(2.0);
+
+	// Initial voxel as a real type. Voxel coordinates are whole numbers, so they're
+	// exact in either precision.
+	const Real3 startCellReal(
+		static_cast<Real>(this->startCell.x),
+		static_cast<Real>(this->startCell.y),
+		static_cast<Real>(this->startCell.z));
+
+	// A custom variable that represents the Y "floor" of the current voxel.
+	const Real eyeYRelativeFloor = startCellReal.y * voxelHeight;
 
-	// Make a copy of the step magnitudes, converted to doubles.
-	const Double3 stepReal(
-		static_cast<double>(step.x),
-		static_cast<double>(step.y),
-		static_cast<double>(step.z));
+	// Delta distances, step directions and initial side distances.
+	const RayStart start = this->getRayStart(direction, voxelHeight);
+	const Real3 &deltaDist = start.deltaDist;
+	const Int3 &step = start.step;
+	Real3 sideDist = start.sideDist;
+
+	// Reciprocals for skipping over empty space along X and Z.
+	const Real invDeltaDistX = one / deltaDist.x;
+	const Real invDeltaDistZ = one / deltaDist.z;
+
+	// Make a copy of the step magnitudes, converted to reals.
+	const Real3 stepReal(
+		static_cast<Real>(step.x),
+		static_cast<Real>(step.y),
+		static_cast<Real>(step.z));
 
 	// Get initial voxel coordinates.
 	Int3 cell = this->startCell;
@@ -370,25 +1515,24 @@ Double3 SoftwareRenderer::castRay(const Double3 &direction,
 	char hitID = 0;
 
 	// Axis of a hit voxel's side. X by default.
-	enum class Axis { X, Y, Z };
-	Axis axis = Axis::X;
+	FaceAxis axis = FaceAxis::X;
 
 	// Distance squared (in voxels) that the ray has stepped. Square roots are
 	// too slow to use in the DDA loop, so this is used instead.
 	// - When using variable-sized voxels, this may be calculated differently.
-	double cellDistSquared = 0.0;
+	Real cellDistSquared = 0.0;
 
 	// Offset values for which corner of a voxel to compare the distance 
 	// squared against. The correct corner to use is important when culling
 	// shapes at max view distance.
-	const Double3 startCellWithOffset(
-		this->startCellReal.x + ((1.0 + stepReal.x) / 2.0),
-		eyeYRelativeFloor + (((1.0 + stepReal.y) / 2.0) * voxelHeight),
-		this->startCellReal.z + ((1.0 + stepReal.z) / 2.0));
-	const Double3 cellOffset(
-		(1.0 - stepReal.x) / 2.0,
-		((1.0 - stepReal.y) / 2.0) * voxelHeight,
-		(1.0 - stepReal.z) / 2.0);
+	const Real3 startCellWithOffset(
+		startCellReal.x + ((one + stepReal.x) / two),
+		eyeYRelativeFloor + (((one + stepReal.y) / two) * voxelHeight),
+		startCellReal.z + ((one + stepReal.z) / two));
+	const Real3 cellOffset(
+		(one - stepReal.x) / two,
+		((one - stepReal.y) / two) * voxelHeight,
+		(one - stepReal.z) / two);
 
 	// Get dimensions of the voxel grid.
 	const int gridWidth = voxelGrid.getWidth();
@@ -404,185 +1548,156 @@ Double3 SoftwareRenderer::castRay(const Double3 &direction,
 	// the total voxel distance stepped is less than the view distance.
 	// (Note that the "voxel distance" is not the same as "actual" distance.)
 	const char *voxels = voxelGrid.getVoxels();
+	const uint8_t *emptyDistances = voxelGrid.getEmptyDistances();
+	const uint64_t *occupancy = voxelGrid.getOccupancy();
+	const int occupancyWidth = voxelGrid.getOccupancyWidth();
+	const int tileShift = VoxelGrid::OCCUPANCY_TILE_SHIFT;
+	const int tileMask = (1 << tileShift) - 1;
 	while (voxelIsValid && (cellDistSquared < this->viewDistSquared))
 	{
+		// Check if the current voxel is solid with its bit in the occupancy bitmap.
+		const uint64_t tile = occupancy[(cell.x >> tileShift) + (cell.y * occupancyWidth) +
+			((cell.z >> tileShift) * occupancyWidth * gridHeight)];
+		const int tileBit = (cell.x & tileMask) | ((cell.z & tileMask) << tileShift);
+
 		// Get the index of the current voxel in the voxel grid.
 		const int gridIndex = cell.x + (cell.y * gridWidth) +
 			(cell.z * gridWidth * gridHeight);
 
-		// Check if the current voxel is solid.
-		const char voxelID = voxels[gridIndex];
-
-		if (voxelID > 0)
+		if (((tile >> tileBit) & 1) != 0)
 		{
-			hitID = voxelID;
+			hitID = voxels[gridIndex];
 			break;
 		}
 
+		// Every voxel in a tile with any solid voxels is within a tile's width of one,
+		// so only all-air tiles can have empty distances worth skipping.
+		if (tile == 0)
+		{
+			const int emptyDistance = emptyDistances[gridIndex];
+
+			// Every voxel on this floor within (emptyDistance - 1) of this one is air, so
+			// jump to the last voxel the ray enters before leaving that square or floor.
+			if (emptyDistance >= SoftwareRenderer::MIN_SKIP_EMPTY_DISTANCE)
+			{
+				const int maxSkip = emptyDistance - 1;
+				const Real exitDist = std::min(sideDist.y, std::min(
+					sideDist.x + (static_cast<Real>(maxSkip) * deltaDist.x),
+					sideDist.z + (static_cast<Real>(maxSkip) * deltaDist.z)));
+				const int skipX = getSkipCrossings(sideDist.x, invDeltaDistX, exitDist, maxSkip);
+				const int skipZ = getSkipCrossings(sideDist.z, invDeltaDistZ, exitDist, maxSkip);
+
+				if (skipX > 0)
+				{
+					sideDist.x += static_cast<Real>(skipX) * deltaDist.x;
+					cell.x += skipX * step.x;
+					voxelIsValid &= (cell.x >= 0) && (cell.x < gridWidth);
+				}
+
+				if (skipZ > 0)
+				{
+					sideDist.z += static_cast<Real>(skipZ) * deltaDist.z;
+					cell.z += skipZ * step.z;
+					voxelIsValid &= (cell.z >= 0) && (cell.z < gridDepth);
+				}
+			}
+		}
+
 		if ((sideDist.x < sideDist.y) && (sideDist.x < sideDist.z))
 		{
 			sideDist.x += deltaDist.x;
 			cell.x += step.x;
-			axis = Axis::X;
+			axis = FaceAxis::X;
 			voxelIsValid &= (cell.x >= 0) && (cell.x < gridWidth);
 		}
 		else if (sideDist.y < sideDist.z)
 		{
 			sideDist.y += deltaDist.y;
 			cell.y += step.y;
-			axis = Axis::Y;
+			axis = FaceAxis::Y;
 			voxelIsValid &= (cell.y >= 0) && (cell.y < gridHeight);
 		}
 		else
 		{
 			sideDist.z += deltaDist.z;
 			cell.z += step.z;
-			axis = Axis::Z;
+			axis = FaceAxis::Z;
 			voxelIsValid &= (cell.z >= 0) && (cell.z < gridDepth);
 		}
 
 		// Refresh how far the current cell is from the start cell, squared.
 		// The "offsets" move each point to the correct corner for each voxel
 		// so that the stepping stops correctly at max view distance.
-		const Double3 cellDiff(
-			(static_cast<double>(cell.x) + cellOffset.x) - startCellWithOffset.x,
-			(static_cast<double>(cell.y) + cellOffset.y) - startCellWithOffset.y,
-			(static_cast<double>(cell.z) + cellOffset.z) - startCellWithOffset.z);
+		const Real3 cellDiff(
+			(static_cast<Real>(cell.x) + cellOffset.x) - startCellWithOffset.x,
+			(static_cast<Real>(cell.y) + cellOffset.y) - startCellWithOffset.y,
+			(static_cast<Real>(cell.z) + cellOffset.z) - startCellWithOffset.z);
 		cellDistSquared = (cellDiff.x * cellDiff.x) + (cellDiff.y * cellDiff.y) +
 			(cellDiff.z * cellDiff.z);
 	}
 
-	// Boolean for whether the ray ended in the same voxel it started in.
-	const bool stoppedInFirstVoxel = cell == this->startCell;
+	return this->getRayColor(direction, cell, axis, hitID, voxelGrid);
+}
 
-	// Get the distance from the camera to the hit point. It is a special case
-	// if the ray stopped in the first voxel.
-	double distance;
-	if (stoppedInFirstVoxel)
+void SoftwareRenderer::castRayPacket(const Real3 *directions, int count,
+	const VoxelGrid &voxelGrid, Real3 *colors) const
+{
+	const int packetSize = getRayPacketSize();
+	assert((count > 0) && (count <= packetSize));
+
+	const CPUFeatures::Tier tier = CPUFeatures::getTier();
+	if (tier == CPUFeatures::Tier::Scalar)
 	{
-		if ((initialSideDist.x < initialSideDist.y) &&
-			(initialSideDist.x < initialSideDist.z))
+		for (int i = 0; i < count; ++i)
 		{
-			distance = initialSideDist.x;
-			axis = Axis::X;
+			colors[i] = this->castRay(directions[i], voxelGrid);
 		}
-		else if (initialSideDist.y < initialSideDist.z)
-		{
-			distance = initialSideDist.y;
-			axis = Axis::Y;
-		}
-		else
-		{
-			distance = initialSideDist.z;
-			axis = Axis::Z;
-		}
-	}
-	else
-	{
-		const size_t axisIndex = static_cast<size_t>(axis);
 
-		// Assign to distance based on which axis was hit.
-		if (axis == Axis::X)
-		{
-			distance = (static_cast<double>(cell.x) - this->eye.x +
-				((1.0 - stepReal.x) / 2.0)) / direction.x;
-		}
-		else if (axis == Axis::Y)
-		{
-			distance = ((static_cast<double>(cell.y) * voxelHeight) - this->eye.y +
-				(((1.0 - stepReal.y) / 2.0) * voxelHeight)) / direction.y;
-		}
-		else
-		{
-			distance = (static_cast<double>(cell.z) - this->eye.z +
-				((1.0 - stepReal.z) / 2.0)) / direction.z;
-		}
+		return;
 	}
 
-	// Simple fog color.
-	const Double3 fog(0.45, 0.75, 1.0);
+	// All rays start in the same voxel.
+	const bool startIsValid = (this->startCell.x >= 0) && (this->startCell.y >= 0) &&
+		(this->startCell.z >= 0) && (this->startCell.x < voxelGrid.getWidth()) &&
+		(this->startCell.y < voxelGrid.getHeight()) &&
+		(this->startCell.z < voxelGrid.getDepth());
 
-	// If there was a hit, get the shaded color.
-	if (hitID > 0)
+	// Unused lanes copy the first ray and start masked off.
+	RayPacket packet;
+	for (int i = 0; i < packetSize; ++i)
 	{
-		// Intersection point on the voxel.
-		const Double3 hitPoint = this->eye + (direction * distance);
-
-		// Boolean for whether the hit point is on the back of a voxel face.
-		const bool backFace = stoppedInFirstVoxel;
-
-		// Texture coordinates. U and V are affected by which side is hit (near, far),
-		// and whether the hit point is on the front or back of the voxel face.
-		// - Note, for edge cases where {u,v}Val == 1.0, the texture coordinate is
-		//   out of bounds by one pixel, so instead of 1.0, something like 0.9999999
-		//   should be used instead. std::nextafter(1.0, -INFINITY)?
-		double u, v;
-		if (axis == Axis::X)
-		{
-			const double uVal = hitPoint.z - std::floor(hitPoint.z);
-
-			u = (nonNegativeDirX ^ backFace) ? uVal : (1.0 - uVal);
-			//v = 1.0 - (hitPoint.y - std::floor(hitPoint.y));
-			v = 1.0 - (std::fmod(hitPoint.y, voxelHeight) / voxelHeight);
-		}
-		else if (axis == Axis::Y)
-		{
-			const double vVal = hitPoint.x - std::floor(hitPoint.x);
-
-			u = hitPoint.z - std::floor(hitPoint.z);
-			v = (nonNegativeDirY ^ backFace) ? vVal : (1.0 - vVal);
-		}
-		else
-		{
-			const double uVal = hitPoint.x - std::floor(hitPoint.x);
-
-			u = (nonNegativeDirZ ^ backFace) ? (1.0 - uVal) : uVal;
-			//v = 1.0 - (hitPoint.y - std::floor(hitPoint.y));
-			v = 1.0 - (std::fmod(hitPoint.y, voxelHeight) / voxelHeight);
-		}
-
-		// -- temp --
-		// Display bad texture coordinates as magenta. If any of these is true, it
-		// means something above is wrong.
-		if ((u < 0.0) || (u >= 1.0) || (v < 0.0) || (v >= 1.0))
-		{
-			return Double3(1.0, 0.0, 1.0);
-		}
-		// -- end temp --
-
-		// Get the voxel data associated with the ID. Subtract 1 because the first
-		// entry is at index 0 but the lowest hitID is 1.
-		const VoxelData &voxelData = voxelGrid.getVoxelData(hitID - 1);
-
-		// Get the texture depending on which face was hit.
-		const TextureData &texture = (axis == Axis::Y) ?
-			this->textures[voxelData.floorAndCeilingID] :
-			this->textures[voxelData.sideID];
-
-		// Calculate position in texture.
-		const int textureX = static_cast<int>(u * texture.width);
-		const int textureY = static_cast<int>(v * texture.height);
-
-		// Get the texel color at the hit point.
-		// - Later, the alpha component can be used for transparency and ignoring
-		//   intersections (in the DDA loop).
-		const Double4 &texel = texture.pixels[textureX + (textureY * texture.width)];
-
-		// Convert the texel to a 3-component color.
-		const Double3 color(texel.x, texel.y, texel.z);
+		const bool laneIsUsed = i < count;
+		const Real3 &direction = directions[laneIsUsed ? i : 0];
+		packet.dirXs[i] = static_cast<float>(direction.x);
+		packet.dirYs[i] = static_cast<float>(direction.y);
+		packet.dirZs[i] = static_cast<float>(direction.z);
+		packet.laneIsActive[i] = (laneIsUsed && startIsValid) ? 1 : 0;
+	}
 
-		// Linearly interpolate with some depth.
-		const double depth = std::min(distance, this->viewDistance) / this->viewDistance;
-		return color.lerp(fog, depth);
+#ifdef CPU_FEATURES_X86
+	if (tier == CPUFeatures::Tier::AVX2)
+	{
+		RayPacketAVX2::castRayPacket(packet, this->startCell, this->eyeOffset,
+			this->viewDistSquared, voxelGrid);
 	}
 	else
 	{
-		// No intersection. Return sky color.
-		return fog;
+		RayPacketSSE2::castRayPacket(packet, this->startCell, this->eyeOffset,
+			this->viewDistSquared, voxelGrid);
+	}
+#endif
+
+	// Shade each ray's hit by itself.
+	for (int i = 0; i < count; ++i)
+	{
+		colors[i] = this->getRayColor(directions[i],
+			Int3(packet.cellXs[i], packet.cellYs[i], packet.cellZs[i]),
+			static_cast<FaceAxis>(packet.axes[i]), static_cast<char>(packet.hitIDs[i]),
+			voxelGrid);
 	}
 }
 
-void SoftwareRenderer::castRay(const Double2 &direction,
+void SoftwareRenderer::castRay(const Real2 &direction,
 	const VoxelGrid &voxelGrid, int x)
 {
 	// This is the "classic" 2.5D version of ray casting, based on Lode Vandevenne's 
@@ -599,46 +1714,52 @@ void SoftwareRenderer::castRay(const Double2 &direction,
 
 	// Because 2D vectors use "X" and "Y", the Z component is actually
 	// aliased as "Y", which is a minor annoyance.
-	const double dirX = direction.x;
-	const double dirZ = direction.y;
-	const double dirXSquared = direction.x * direction.x;
-	const double dirZSquared = direction.y * direction.y;
+	const Real dirX = direction.x;
+	const Real dirZ = direction.y;
+	const Real dirXSquared = direction.x * direction.x;
+	const Real dirZSquared = direction.y * direction.y;
 
-	const double deltaDistX = std::sqrt(1.0 + (dirZSquared / dirXSquared));
-	const double deltaDistZ = std::sqrt(1.0 + (dirXSquared / dirZSquared));
+	const Real one = static_cast<Real>(1.0);
+	const Real deltaDistX = std::sqrt(one + (dirZSquared / dirXSquared));
+	const Real deltaDistZ = std::sqrt(one + (dirXSquared / dirZSquared));
+
+	// Reciprocals for skipping over empty space.
+	const Real invDeltaDistX = one / deltaDistX;
+	const Real invDeltaDistZ = one / deltaDistZ;
 
 	const bool nonNegativeDirX = direction.x >= 0.0;
 	const bool nonNegativeDirZ = direction.y >= 0.0;
 
+	// The initial side distances only depend on where the eye is within its voxel.
 	int stepX, stepZ;
-	double sideDistX, sideDistZ;
+	Real sideDistX, sideDistZ;
 	if (nonNegativeDirX)
 	{
 		stepX = 1;
-		sideDistX = (this->startCellReal.x + 1.0 - this->eye.x) * deltaDistX;
+		sideDistX = (one - this->eyeOffset.x) * deltaDistX;
 	}
 	else
 	{
 		stepX = -1;
-		sideDistX = (this->eye.x - this->startCellReal.x) * deltaDistX;
+		sideDistX = this->eyeOffset.x * deltaDistX;
 	}
 
 	if (nonNegativeDirZ)
 	{
 		stepZ = 1;
-		sideDistZ = (this->startCellReal.z + 1.0 - this->eye.z) * deltaDistZ;
+		sideDistZ = (one - this->eyeOffset.z) * deltaDistZ;
 	}
 	else
 	{
 		stepZ = -1;
-		sideDistZ = (this->eye.z - this->startCellReal.z) * deltaDistZ;
+		sideDistZ = this->eyeOffset.z * deltaDistZ;
 	}
 
 	// Make a copy of the initial side distances for the special case of ending in
 	// the first voxel. This is the oblique distance though, so some changes will
 	// be necessary.
-	const double initialSideDistX = sideDistX;
-	const double initialSideDistZ = sideDistZ;
+	const Real initialSideDistX = sideDistX;
+	const Real initialSideDistZ = sideDistZ;
 
 	const int gridWidth = voxelGrid.getWidth();
 	const int gridHeight = voxelGrid.getHeight();
@@ -652,8 +1773,14 @@ void SoftwareRenderer::castRay(const Double2 &direction,
 	enum class Axis { X, Z };
 	Axis axis = Axis::X;
 
-	// Pointer to voxel ID grid data.
+	// Pointers to voxel ID grid data, the distance to solid voxels, and the
+	// occupancy bitmap.
 	const char *voxels = voxelGrid.getVoxels();
+	const uint8_t *emptyDistances = voxelGrid.getEmptyDistances();
+	const uint64_t *occupancy = voxelGrid.getOccupancy();
+	const int occupancyWidth = voxelGrid.getOccupancyWidth();
+	const int tileShift = VoxelGrid::OCCUPANCY_TILE_SHIFT;
+	const int tileMask = (1 << tileShift) - 1;
 
 	// Voxel ID of a hit voxel, if any. Zero is "air".
 	char hitID = 0;
@@ -664,19 +1791,55 @@ void SoftwareRenderer::castRay(const Double2 &direction,
 
 	while (voxelIsValid)
 	{
+		// Check if the current voxel is solid with its bit in the occupancy bitmap.
+		const uint64_t tile = occupancy[(cellX >> tileShift) + (cellY * occupancyWidth) +
+			((cellZ >> tileShift) * occupancyWidth * gridHeight)];
+		const int tileBit = (cellX & tileMask) | ((cellZ & tileMask) << tileShift);
+
 		// Get the index of the current voxel in the voxel grid.
 		const int gridIndex = cellX + (cellY * gridWidth) +
 			(cellZ * gridWidth * gridHeight);
 
-		// Check if the current voxel is solid.
-		const char voxelID = voxels[gridIndex];
-
-		if (voxelID > 0)
+		if (((tile >> tileBit) & 1) != 0)
 		{
-			hitID = voxelID;
+			hitID = voxels[gridIndex];
 			break;
 		}
 
+		// Every voxel in a tile with any solid voxels is within a tile's width of one,
+		// so only all-air tiles can have empty distances worth skipping.
+		if (tile == 0)
+		{
+			const int emptyDistance = emptyDistances[gridIndex];
+
+			// Every voxel within (emptyDistance - 1) of this one is air, so jump to the
+			// last voxel the ray enters before leaving that square. The step below then
+			// leaves it.
+			if (emptyDistance >= SoftwareRenderer::MIN_SKIP_EMPTY_DISTANCE)
+			{
+				const int maxSkip = emptyDistance - 1;
+				const Real exitDist = std::min(
+					sideDistX + (static_cast<Real>(maxSkip) * deltaDistX),
+					sideDistZ + (static_cast<Real>(maxSkip) * deltaDistZ));
+				const int skipX = getSkipCrossings(sideDistX, invDeltaDistX, exitDist, maxSkip);
+				const int skipZ = getSkipCrossings(sideDistZ, invDeltaDistZ, exitDist, maxSkip);
+
+				if (skipX > 0)
+				{
+					sideDistX += static_cast<Real>(skipX) * deltaDistX;
+					cellX += skipX * stepX;
+					voxelIsValid &= (cellX >= 0) && (cellX < gridWidth);
+				}
+
+				if (skipZ > 0)
+				{
+					sideDistZ += static_cast<Real>(skipZ) * deltaDistZ;
+					cellZ += skipZ * stepZ;
+					voxelIsValid &= (cellZ >= 0) && (cellZ < gridDepth);
+				}
+			}
+		}
+
 		if (sideDistX < sideDistZ)
 		{
 			sideDistX += deltaDistX;
@@ -693,6 +1856,12 @@ void SoftwareRenderer::castRay(const Double2 &direction,
 		}
 	}
 
+	// The column's depth is infinite unless a wall is drawn.
+	ColumnDepth &columnDepth = this->columnDepths[x];
+	columnDepth.wallDepth = std::numeric_limits<Real>::infinity();
+	columnDepth.wallStart = 0;
+	columnDepth.wallEnd = 0;
+
 	// If hit ID is positive, a wall was hit.
 	if (hitID > 0)
 	{
@@ -702,7 +1871,7 @@ void SoftwareRenderer::castRay(const Double2 &direction,
 
 		// The "z-distance" from the camera to the wall. It's a special case if the
 		// stepping stopped in the first voxel.
-		double zDistance;
+		Real zDistance;
 		if (stoppedInFirstVoxel)
 		{
 			// To do: figure out the correct initial side distance calculation.
@@ -720,43 +1889,48 @@ void SoftwareRenderer::castRay(const Double2 &direction,
 		}
 		else
 		{
+			// Cells are relative to the start voxel like the eye offset.
 			zDistance = (axis == Axis::X) ?
-				(static_cast<double>(cellX) - this->eye.x + static_cast<double>((1 - stepX) / 2)) / dirX :
-				(static_cast<double>(cellZ) - this->eye.z + static_cast<double>((1 - stepZ) / 2)) / dirZ;
+				(static_cast<Real>(cellX - this->startCell.x) - this->eyeOffset.x +
+					static_cast<Real>((1 - stepX) / 2)) / dirX :
+				(static_cast<Real>(cellZ - this->startCell.z) - this->eyeOffset.z +
+					static_cast<Real>((1 - stepZ) / 2)) / dirZ;
 		}
 
 		// Boolean for whether the intersected voxel face is a back face.
 		const bool backFace = stoppedInFirstVoxel;
 
-		// 3D hit point on the wall from casting a ray along the XZ plane.
-		const Double3 hitPoint(
-			this->eye.x + (dirX * zDistance),
-			this->eye.y,
-			this->eye.z + (dirZ * zDistance));
+		// Offset from the eye to the hit point on the wall from casting a ray along the
+		// XZ plane.
+		const Real hitOffsetX = dirX * zDistance;
+		const Real hitOffsetZ = dirZ * zDistance;
 
-		// Horizontal texture coordinate (constant for all wall pixels in a column).
+		// Horizontal texture coordinate (constant for all wall pixels in a column), from
+		// the hit point relative to the start voxel.
 		// - Remember to watch out for the edge cases where u == 1.0, resulting in an
 		//   out-of-bounds texel access. Maybe use std::nextafter() for ~0.9999999?
-		double u;
+		Real u;
 		if (axis == Axis::X)
 		{
-			const double uVal = hitPoint.z - std::floor(hitPoint.z);
-			u = (nonNegativeDirX ^ backFace) ? uVal : (1.0 - uVal);
+			const Real hitZ = this->eyeOffset.z + hitOffsetZ;
+			const Real uVal = hitZ - std::floor(hitZ);
+			u = (nonNegativeDirX ^ backFace) ? uVal : (one - uVal);
 		}
 		else
 		{
-			const double uVal = hitPoint.x - std::floor(hitPoint.x);
-			u = (nonNegativeDirZ ^ backFace) ? (1.0 - uVal) : uVal;
+			const Real hitX = this->eyeOffset.x + hitOffsetX;
+			const Real uVal = hitX - std::floor(hitX);
+			u = (nonNegativeDirZ ^ backFace) ? (one - uVal) : uVal;
 		}
 
 		// Generate a point on the ceiling edge and floor edge of the wall relative
-		// to the hit point.
-		const Double3 ceilingPoint(hitPoint.x, std::ceil(hitPoint.y), hitPoint.z);
-		const Double3 floorPoint(hitPoint.x, std::floor(hitPoint.y), hitPoint.z);
+		// to the eye.
+		const Real ceilingY = static_cast<Real>(std::ceil(this->eye.y) - this->eye.y);
+		const Real floorY = static_cast<Real>(std::floor(this->eye.y) - this->eye.y);
 
 		// Transform the points to camera space (projection * view).
-		Double4 p1 = this->transform * Double4(ceilingPoint.x, ceilingPoint.y, ceilingPoint.z, 1.0);
-		Double4 p2 = this->transform * Double4(floorPoint.x, floorPoint.y, floorPoint.z, 1.0);
+		Real4 p1 = this->transform * Real4(hitOffsetX, ceilingY, hitOffsetZ, one);
+		Real4 p2 = this->transform * Real4(hitOffsetX, floorY, hitOffsetZ, one);
 
 		// Convert to normalized coordinates.
 		p1 = p1 / p1.w;
@@ -771,19 +1945,20 @@ void SoftwareRenderer::castRay(const Double2 &direction,
 		// - This value will usually be non-zero in the "modern" interface mode.
 		// - Maybe it should involve the angle between horizontal and vertical, because if
 		//   the player is looking halfway between, then the elevation would be sqrt(2) / 2.
-		const double cameraElevation = this->forward.y;
+		const Real cameraElevation = static_cast<Real>(this->forward.y);
 
 		// Translate the Y coordinates relative to the center of Y projection (y == 0.5).
 		// Add camera elevation for "fake" looking up and down. Multiply by 0.5 to apply the 
 		// correct aspect ratio.
 		// - Since the ray cast guarantees the intersection to be in the correct column
 		//   of the screen, only the Y coordinates need to be projected.
-		const double projectedY1 = (0.50 + cameraElevation) - (p1.y * 0.50);
-		const double projectedY2 = (0.50 + cameraElevation) - (p2.y * 0.50);
+		const Real half = static_cast<Real>(0.50);
+		const Real projectedY1 = (half + cameraElevation) - (p1.y * half);
+		const Real projectedY2 = (half + cameraElevation) - (p2.y * half);
 
 		// Get the start and end Y pixel coordinates of the projected points (potentially
 		// outside the top or bottom of the screen).
-		const double heightReal = static_cast<double>(this->height);
+		const Real heightReal = static_cast<Real>(this->height);
 		const int projectedStart = static_cast<int>(std::round(projectedY1 * heightReal));
 		const int projectedEnd = static_cast<int>(std::round(projectedY2 * heightReal));
 
@@ -795,59 +1970,109 @@ void SoftwareRenderer::castRay(const Double2 &direction,
 		// is 1 and textures start at 0.
 		const TextureData &texture = this->textures[hitID - 1];
 
+		// Mip level for how many texels tall the projected column is per pixel.
+		const int mipLevel = SoftwareRenderer::getMipLevel(texture,
+			static_cast<Real>(texture.height) /
+			static_cast<Real>(std::max(projectedEnd - projectedStart, 1)));
+		const int levelWidth = std::max(texture.width >> mipLevel, 1);
+		const int levelHeight = std::max(texture.height >> mipLevel, 1);
+
 		// X position in texture (temporarily using modulo to protect against edge cases 
 		// where u == 1.0; it should be fixed in the u calculation instead).
 		const int textureX = static_cast<int>(u *
-			static_cast<double>(texture.width)) % texture.width;
+			static_cast<Real>(levelWidth)) % levelWidth;
+
+		// Start of the texture's column of texels for this screen column.
+		const int texelColumnOffset = texture.levelOffsets[mipLevel] +
+			(textureX * levelHeight);
 
-		// Linearly interpolated fog.
-		const Double3 fogColor(0.40, 0.65, 1.0);
-		const double fogPercent = std::min(zDistance, this->viewDistance) / this->viewDistance;
+		columnDepth.wallDepth = zDistance;
+		columnDepth.wallStart = drawStart;
+		columnDepth.wallEnd = drawEnd;
 
-		// Draw each wall pixel in the column.
-		uint32_t *pixels = this->colorBuffer.data();
-		double *depth = this->zBuffer.data();
-		for (int y = drawStart; y < drawEnd; ++y)
+		if (this->frameIndexed)
+		{
+			// Same as below, but with palette indices and the shade table.
+			const uint8_t *indexColumn = texture.indices.data() + texelColumnOffset;
+			const uint8_t *shadeRow = this->getShadeTableRow(zDistance);
+			uint8_t *indices = this->indexBuffer.data();
+			for (int y = drawStart; y < drawEnd; ++y)
+			{
+				const Real v = static_cast<Real>(y - projectedStart) /
+					static_cast<Real>(projectedEnd - projectedStart);
+				const int textureY = static_cast<int>(v * static_cast<Real>(levelHeight));
+				indices[x + (y * this->width)] = shadeRow[indexColumn[textureY]];
+			}
+		}
+		else
 		{
-			// Vertical texture coordinate.
-			const double v = static_cast<double>(y - projectedStart) /
-				static_cast<double>(projectedEnd - projectedStart);
+			const uint32_t *texelColumn = texture.pixels.data() + texelColumnOffset;
+
+			// Linearly interpolated fog.
+			const uint8_t *fogRow = this->getFogTableRow(zDistance);
+
+			// Draw each wall pixel in the column.
+			uint32_t *pixels = this->outputPixels;
+			for (int y = drawStart; y < drawEnd; ++y)
+			{
+				// Vertical texture coordinate.
+				const Real v = static_cast<Real>(y - projectedStart) /
+					static_cast<Real>(projectedEnd - projectedStart);
 
-			// Y position in texture.
-			const int textureY = static_cast<int>(v * static_cast<double>(texture.height));
+				// Y position in texture.
+				const int textureY = static_cast<int>(v * static_cast<Real>(levelHeight));
+
+				const uint32_t texel = texelColumn[textureY];
+
+				const int index = x + (y * this->outputPitch);
+				pixels[index] = applyFog(texel, fogRow);
+			}
+		}
+	}
+
+	// Floors, ceilings, and flats are drawn in later passes, once every column's
+	// wall bounds are known (see renderFloorRows() and drawFlats()).
+}
+
+void SoftwareRenderer::drawFlats(int x, float *flatDepths)
+{
+	// Sprites.
+	// - Sprites are drawn by column after the floors and ceilings, since they can stand
+	//   in front of either. Parallelizing by column means a little redundant work.
 
-			const Double4 &texel = texture.pixels[textureX + (textureY * texture.width)];
-			const Double3 color(texel.x, texel.y, texel.z);
+	// - To do: go through all of this again and verify the math for correctness.
 
-			const int index = x + (y * this->width);
-			pixels[index] = color.lerp(fogColor, fogPercent).clamped().toRGB();
-			depth[index] = zDistance;
-		}
-	}
+	const ColumnDepth &columnDepth = this->columnDepths[x];
 
-	// Floor/ceiling...
-	// - I wonder how it should start if no wall was hit. Maybe project the floor based on
-	//   where the stepping stopped to get a Y coordinate?
-	// - Do not depend on when a wall on the current floor is hit. Floor/ceiling casting
-	//   can continue as far as it needs to.
+	// X percent across the screen.
+	const Real xPercent = static_cast<Real>(x) /
+		static_cast<Real>(this->width);
 
-	// Sprites.
-	// - Sprites *could* be done outside the ray casting loop, though they would need to be
-	//   parallelized a bit differently then. Here, it is easy to parallelize by column,
-	//   so it might be faster in practice, even if a little redundant work is done.
+	// Rows of the flat depth buffer that have been initialized for this column. Rows
+	// are only initialized (from the wall depth) once a flat covers them.
+	int flatDepthStart = 0;
+	int flatDepthEnd = 0;
+	const float wallDepth = static_cast<float>(columnDepth.wallDepth);
+	auto initFlatDepths = [flatDepths, &columnDepth, wallDepth](int start, int end)
+	{
+		for (int y = start; y < end; ++y)
+		{
+			const bool isWall = (y >= columnDepth.wallStart) && (y < columnDepth.wallEnd);
+			flatDepths[y] = isWall ? wallDepth : std::numeric_limits<float>::infinity();
+		}
+	};
 
-	// - To do: go through all of this again and verify the math for correctness.
-	for (const auto &pair : this->visibleFlats)
+	// Only flats in this column's bin can overlap it.
+	const std::vector<int> &flatBin =
+		this->visibleFlatBins[x / SoftwareRenderer::COLUMN_TILE_WIDTH];
+	for (const int flatIndex : flatBin)
 	{
+		const auto &pair = this->visibleFlats[flatIndex];
 		const Flat &flat = *pair.first;
 		const Flat::ProjectionData &projectionData = pair.second;
 
-		// X percent across the screen.
-		const double xPercent = static_cast<double>(x) /
-			static_cast<double>(this->width);
-
 		// Find where the column is within the X range of the flat.
-		const double xRangePercent = (xPercent - projectionData.rightX) /
+		const Real xRangePercent = (xPercent - projectionData.rightX) /
 			(projectionData.leftX - projectionData.rightX);
 
 		// Don't render the flat if the X range percent is invalid.
@@ -857,17 +2082,17 @@ void SoftwareRenderer::castRay(const Double2 &direction,
 		}
 
 		// Horizontal texture coordinate in the flat.
-		const double u = xRangePercent;
+		const Real u = xRangePercent;
 
 		// Interpolate the projected Y coordinates based on the X range.
-		const double projectedY1 = projectionData.topRightY +
+		const Real projectedY1 = projectionData.topRightY +
 			((projectionData.topLeftY - projectionData.topRightY) * xRangePercent);
-		const double projectedY2 = projectionData.bottomRightY +
+		const Real projectedY2 = projectionData.bottomRightY +
 			((projectionData.bottomLeftY - projectionData.bottomRightY) * xRangePercent);
 
 		// Get the start and end Y pixel coordinates of the projected points (potentially
 		// outside the top or bottom of the screen).
-		const double heightReal = static_cast<double>(this->height);
+		const Real heightReal = static_cast<Real>(this->height);
 		const int projectedStart = static_cast<int>(std::round(projectedY1 * heightReal));
 		const int projectedEnd = static_cast<int>(std::round(projectedY2 * heightReal));
 
@@ -878,47 +2103,599 @@ void SoftwareRenderer::castRay(const Double2 &direction,
 		// The texture associated with the voxel ID.
 		const TextureData &texture = this->textures[flat.textureID];
 
+		// Mip level for how many texels tall the projected column is per pixel.
+		const int mipLevel = SoftwareRenderer::getMipLevel(texture,
+			static_cast<Real>(texture.height) /
+			static_cast<Real>(std::max(projectedEnd - projectedStart, 1)));
+		const int levelWidth = std::max(texture.width >> mipLevel, 1);
+		const int levelHeight = std::max(texture.height >> mipLevel, 1);
+
 		// X position in texture (temporarily using modulo to protect against edge cases 
 		// where u == 1.0; it should be fixed in the u calculation instead).
 		const int textureX = static_cast<int>(u *
-			static_cast<double>(texture.width)) % texture.width;
+			static_cast<Real>(levelWidth)) % levelWidth;
+
+		// Start of the texture's column of texels for this screen column.
+		const int texelColumnOffset = texture.levelOffsets[mipLevel] +
+			(textureX * levelHeight);
+
+		const Real nearZ = std::min(projectionData.leftZ, projectionData.rightZ);
+		const Real farZ = std::max(projectionData.leftZ, projectionData.rightZ);
+		const Real zDistance = nearZ + ((farZ - nearZ) * xRangePercent);
+
+		if (drawStart >= drawEnd)
+		{
+			continue;
+		}
+
+		// Grow the initialized range of flat depths to cover the flat.
+		if (flatDepthStart == flatDepthEnd)
+		{
+			initFlatDepths(drawStart, drawEnd);
+			flatDepthStart = drawStart;
+			flatDepthEnd = drawEnd;
+		}
+		else
+		{
+			if (drawStart < flatDepthStart)
+			{
+				initFlatDepths(drawStart, flatDepthStart);
+				flatDepthStart = drawStart;
+			}
+
+			if (drawEnd > flatDepthEnd)
+			{
+				initFlatDepths(flatDepthEnd, drawEnd);
+				flatDepthEnd = drawEnd;
+			}
+		}
+
+		const float flatDepth = static_cast<float>(zDistance);
+		if (this->frameIndexed)
+		{
+			// Same as below, but with palette indices and the shade table.
+			const uint8_t *indexColumn = texture.indices.data() + texelColumnOffset;
+			const uint8_t *shadeRow = this->getShadeTableRow(zDistance);
+			uint8_t *indices = this->indexBuffer.data();
+			for (int y = drawStart; y < drawEnd; ++y)
+			{
+				const Real v = static_cast<Real>(y - projectedStart) /
+					static_cast<Real>(projectedEnd - projectedStart);
+				const int textureY = static_cast<int>(v * static_cast<Real>(levelHeight));
+				if (flatDepth < flatDepths[y])
+				{
+					indices[x + (y * this->width)] = shadeRow[indexColumn[textureY]];
+					flatDepths[y] = flatDepth;
+				}
+			}
+		}
+		else
+		{
+			const uint32_t *texelColumn = texture.pixels.data() + texelColumnOffset;
+
+			// Linearly interpolated fog.
+			const uint8_t *fogRow = this->getFogTableRow(zDistance);
+
+			uint32_t *pixels = this->outputPixels;
+			for (int y = drawStart; y < drawEnd; ++y)
+			{
+				// Vertical texture coordinate.
+				const Real v = static_cast<Real>(y - projectedStart) /
+					static_cast<Real>(projectedEnd - projectedStart);
+
+				// Y position in texture.
+				const int textureY = static_cast<int>(v * static_cast<Real>(levelHeight));
+
+				const uint32_t texel = texelColumn[textureY];
+
+				const int index = x + (y * this->outputPitch);
+
+				// Draw if less than the current depth.
+				if (flatDepth < flatDepths[y])
+				{
+					pixels[index] = applyFog(texel, fogRow);
+					flatDepths[y] = flatDepth;
+				}
+			}
+		}
+	}
+}
+
+void SoftwareRenderer::renderFloorRows(int startX, int startY, int endX, int endY)
+{
+	const VoxelGrid &voxelGrid = *this->frameVoxelGrid;
+	const int gridWidth = voxelGrid.getWidth();
+	const int gridHeight = voxelGrid.getHeight();
+	const int gridDepth = voxelGrid.getDepth();
+	const char *voxels = voxelGrid.getVoxels();
+	const Real voxelHeight = static_cast<Real>(voxelGrid.getVoxelHeight());
+	const Real widthReal = static_cast<Real>(this->width);
+	const Real heightReal = static_cast<Real>(this->height);
+	const Real half = static_cast<Real>(0.50);
+	const Real two = static_cast<Real>(2.0);
+
+	// The floor is the top of the voxel level below the eye's, and the ceiling is the
+	// bottom of the level above it, like the bottom and top edges of the walls.
+	const int floorCellY = this->startCell.y - 1;
+	const int ceilingCellY = this->startCell.y + 1;
+	const int startCellX = this->startCell.x;
+	const int startCellZ = this->startCell.z;
+	const Real floorHeight = -this->eyeOffset.y;
+	const Real ceilingHeight = floorHeight + voxelHeight;
+
+	// A point on a horizontal plane at height h relative to the eye and distance d
+	// along the horizontal forward vector is projected to a normalized Y coordinate of
+	// (zoom * ((d * a) + (h * b))) / ((d * c) + (h * e)) by the view and projection
+	// matrices (see castRay()). Points that differ only along the right vector have
+	// the same Y, so each screen row of a plane is at a constant distance.
+	const Real zoom = this->frameForwardComp.length();
+	const Real3 forward = toReal(this->forward);
+	const Real3 forward2D(this->frameForwardComp.x / zoom, static_cast<Real>(0.0),
+		this->frameForwardComp.y / zoom);
+	const Real a = forward2D.dot(this->frameUp);
+	const Real b = this->frameUp.y;
+	const Real c = forward2D.dot(forward);
+	const Real e = forward.y;
+	const Real cameraElevation = forward.y;
+
+	// The 2D ray through the left edge of the screen and the change from one column's
+	// ray to the next (see renderColumns()). Points on the planes are relative to the
+	// start voxel, so they keep their precision far from the origin.
+	const Real2 leftDirection = this->frameForwardComp -
+		(this->frameRight2D * this->frameAspect);
+	const Real2 columnStep = this->frameRight2D * ((two * this->frameAspect) / widthReal);
+	const Real2 eye2D(this->eyeOffset.x, this->eyeOffset.z);
+	const Real viewDistance = static_cast<Real>(this->viewDistance);
+
+	// Distance along the horizontal forward vector per unit of plane height for a
+	// screen row. The row sees the floor if it's negative and the ceiling if it's
+	// positive.
+	auto getDistancePerHeight = [heightReal, half, two, cameraElevation, zoom,
+		a, b, c, e](int y)
+	{
+		// Normalized Y coordinate of the row's center, undoing the Y-shearing.
+		const Real yPercent = (static_cast<Real>(y) + half) / heightReal;
+		const Real projectedY = two * ((half + cameraElevation) - yPercent);
+		return ((projectedY * e) - (zoom * b)) / ((zoom * a) - (projectedY * c));
+	};
 
-		const double nearZ = std::min(projectionData.leftZ, projectionData.rightZ);
-		const double farZ = std::max(projectionData.leftZ, projectionData.rightZ);
-		const double zDistance = nearZ + ((farZ - nearZ) * xRangePercent);
+	uint32_t *pixels = this->outputPixels;
+	for (int y = startY; y < endY; ++y)
+	{
+		const Real distancePerHeight = getDistancePerHeight(y);
+		if ((distancePerHeight == 0.0) || !std::isfinite(distancePerHeight))
+		{
+			continue;
+		}
 
-		// Linearly interpolated fog.
-		const Double3 fogColor(0.40, 0.65, 1.0);
-		const double fogPercent = std::min(zDistance, this->viewDistance) / this->viewDistance;
+		const bool isFloor = distancePerHeight < 0.0;
+		const int cellY = isFloor ? floorCellY : ceilingCellY;
+		if ((cellY < 0) || (cellY >= gridHeight))
+		{
+			continue;
+		}
 
-		uint32_t *pixels = this->colorBuffer.data();
-		double *depth = this->zBuffer.data();
-		for (int y = drawStart; y < drawEnd; ++y)
+		// Distance in units of the un-normalized 2D ray direction, like the wall depth
+		// in castRay(). Rows past the view distance are fully fogged, which is the same
+		// as the sky color already there.
+		const Real planeHeight = isFloor ? floorHeight : ceilingHeight;
+		const Real rayDistance = (distancePerHeight * planeHeight) / zoom;
+		if (rayDistance >= viewDistance)
 		{
-			// Vertical texture coordinate.
-			const double v = static_cast<double>(y - projectedStart) /
-				static_cast<double>(projectedEnd - projectedStart);
+			continue;
+		}
 
-			// Y position in texture.
-			const int textureY = static_cast<int>(v * static_cast<double>(texture.height));
+		const uint8_t *fogRow = this->getFogTableRow(rayDistance);
+		const uint8_t *shadeRow = this->frameIndexed ?
+			this->getShadeTableRow(rayDistance) : nullptr;
+		const Real2 rowStart = eye2D + (leftDirection * rayDistance);
+		const Real2 rowStep = columnStep * rayDistance;
+
+		// Voxel widths covered by a pixel, both along the row and toward the next row.
+		// The larger one picks the mip level.
+		const Real rowDepthStep = std::abs(
+			(getDistancePerHeight(y + 1) - distancePerHeight) * planeHeight);
+		const Real pixelFootprint = std::max(rowStep.length(), rowDepthStep);
+
+		uint32_t *row = pixels + (y * this->outputPitch);
+		uint8_t *indexRow = this->frameIndexed ?
+			(this->indexBuffer.data() + (y * this->width)) : nullptr;
+		for (int x = startX; x < endX; ++x)
+		{
+			// Pixels covered by the column's wall are closer than the plane.
+			const ColumnDepth &columnDepth = this->columnDepths[x];
+			if ((y >= columnDepth.wallStart) && (y < columnDepth.wallEnd))
+			{
+				continue;
+			}
 
-			const Double4 &texel = texture.pixels[textureX + (textureY * texture.width)];
-			const Double3 color(texel.x, texel.y, texel.z);
+			// Points are relative to the start voxel, so they can be negative.
+			const Real pointX = rowStart.x + (rowStep.x * static_cast<Real>(x));
+			const Real pointZ = rowStart.y + (rowStep.y * static_cast<Real>(x));
+			const int offsetX = floorToInt(pointX);
+			const int offsetZ = floorToInt(pointZ);
+			const int cellX = startCellX + offsetX;
+			const int cellZ = startCellZ + offsetZ;
+			if ((cellX < 0) || (cellZ < 0) || (cellX >= gridWidth) || (cellZ >= gridDepth))
+			{
+				continue;
+			}
 
-			const int index = x + (y * this->width);
+			// Only solid voxels have a floor or ceiling face to draw.
+			const char voxelID = voxels[cellX + (cellY * gridWidth) +
+				(cellZ * gridWidth * gridHeight)];
+			if (voxelID <= 0)
+			{
+				continue;
+			}
 
-			// Draw if less than the current depth.
-			if (zDistance < depth[index])
+			// The texture associated with the voxel ID, sampled at the point's place
+			// within the voxel.
+			const TextureData &texture = this->textures[voxelID - 1];
+			const int mipLevel = SoftwareRenderer::getMipLevel(texture,
+				pixelFootprint * static_cast<Real>(texture.width));
+			const int levelWidth = std::max(texture.width >> mipLevel, 1);
+			const int levelHeight = std::max(texture.height >> mipLevel, 1);
+			const int textureX = std::min(static_cast<int>(
+				(pointX - static_cast<Real>(offsetX)) * static_cast<Real>(levelWidth)),
+				levelWidth - 1);
+			const int textureY = std::min(static_cast<int>(
+				(pointZ - static_cast<Real>(offsetZ)) * static_cast<Real>(levelHeight)),
+				levelHeight - 1);
+			const int texelIndex = texture.levelOffsets[mipLevel] +
+				(textureX * levelHeight) + textureY;
+
+			// The branch goes the same way for the whole frame.
+			if (indexRow != nullptr)
 			{
-				pixels[index] = color.lerp(fogColor, fogPercent).clamped().toRGB();
-				depth[index] = zDistance;
+				indexRow[x] = shadeRow[texture.indices[texelIndex]];
+			}
+			else
+			{
+				row[x] = applyFog(texture.pixels[texelIndex], fogRow);
 			}
 		}
 	}
 }
 
+SoftwareRenderer::SceneState SoftwareRenderer::getSceneState(
+	const VoxelGrid &voxelGrid) const
+{
+	SceneState sceneState;
+	sceneState.eye = this->eye;
+	sceneState.forward = this->forward;
+	sceneState.fogColor = this->fogColor;
+	sceneState.fovY = this->fovY;
+	sceneState.viewDistance = this->viewDistance;
+	sceneState.voxelGrid = &voxelGrid;
+	sceneState.voxelRevision = voxelGrid.getRevision();
+	sceneState.full3D = this->full3D;
+	return sceneState;
+}
+
+bool SoftwareRenderer::drawsIndices() const
+{
+	// Full 3D colors aren't limited to a palette.
+	return this->indexed && !this->full3D && (this->palette.size() > 0);
+}
+
+SoftwareRenderer::FrameChange SoftwareRenderer::getFrameChange(
+	const VoxelGrid &voxelGrid) const
+{
+	const SceneState sceneState = this->getSceneState(voxelGrid);
+	const SceneState &last = this->lastSceneState;
+	const bool sceneChanged = this->sceneDirty || (sceneState.eye != last.eye) ||
+		(sceneState.forward != last.forward) || (sceneState.fogColor != last.fogColor) ||
+		(sceneState.fovY != last.fovY) || (sceneState.viewDistance != last.viewDistance) ||
+		(sceneState.voxelGrid != last.voxelGrid) ||
+		(sceneState.voxelRevision != last.voxelRevision) ||
+		(sceneState.full3D != last.full3D);
+	if (sceneChanged)
+	{
+		return FrameChange::All;
+	}
+
+	// Flats are only drawn in 2.5D.
+	const bool flatsChanged = !this->full3D && (std::find(this->dirtyColumnTiles.begin(),
+		this->dirtyColumnTiles.end(), true) != this->dirtyColumnTiles.end());
+	if (flatsChanged)
+	{
+		return FrameChange::Columns;
+	}
+
+	return this->outputPaletteDirty ? FrameChange::Palette : FrameChange::None;
+}
+
 void SoftwareRenderer::render(const VoxelGrid &voxelGrid)
 {
+	assert(!this->renderPending);
+
+	// The frame buffer only has the last frame if it was drawn here.
+	const FrameChange frameChange = this->colorBufferCurrent ?
+		this->getFrameChange(voxelGrid) : FrameChange::All;
+	const int pitch = this->width * static_cast<int>(sizeof(uint32_t));
+	if (frameChange == FrameChange::Palette)
+	{
+		this->beginPaletteFrame(this->colorBuffer.data(), pitch);
+		this->endFrame();
+	}
+	else if (frameChange != FrameChange::None)
+	{
+		this->beginFrame(voxelGrid, this->colorBuffer.data(), pitch,
+			frameChange == FrameChange::Columns);
+		this->endFrame();
+	}
+	else
+	{
+		this->clearTimings();
+	}
+
+	this->colorBufferCurrent = true;
+}
+
+void SoftwareRenderer::render(const VoxelGrid &voxelGrid, uint32_t *pixels, int pitch)
+{
+	assert(!this->renderPending);
+	this->beginFrame(voxelGrid, pixels, pitch, false);
+	this->endFrame();
+	this->colorBufferCurrent = false;
+}
+
+void SoftwareRenderer::startRender(const VoxelGrid &voxelGrid)
+{
+	assert(!this->renderPending);
+
+	// The back buffer is only allocated when pipelining is used.
+	if (this->backColorBuffer.size() != this->colorBuffer.size())
+	{
+		this->backColorBuffer.resize(this->colorBuffer.size());
+	}
+
+	const FrameChange frameChange = this->colorBufferCurrent ?
+		this->getFrameChange(voxelGrid) : FrameChange::All;
+	if (frameChange == FrameChange::Columns)
+	{
+		// The back buffer has an older frame, so start from the last one.
+		std::copy(this->colorBuffer.begin(), this->colorBuffer.end(),
+			this->backColorBuffer.begin());
+	}
+
+	// A palette frame converts every pixel, so it doesn't need the last frame.
+	const int pitch = this->width * static_cast<int>(sizeof(uint32_t));
+	if (frameChange == FrameChange::Palette)
+	{
+		this->beginPaletteFrame(this->backColorBuffer.data(), pitch);
+	}
+	else if (frameChange != FrameChange::None)
+	{
+		this->beginFrame(voxelGrid, this->backColorBuffer.data(), pitch,
+			frameChange == FrameChange::Columns);
+	}
+	else
+	{
+		this->clearTimings();
+	}
+
+	this->pendingFrameDrawn = frameChange != FrameChange::None;
+	this->renderPending = true;
+}
+
+bool SoftwareRenderer::finishRender()
+{
+	assert(this->renderPending);
+
+	// The finished frame becomes the one returned by getPixels(). A reused frame is
+	// already there.
+	if (this->pendingFrameDrawn)
+	{
+		this->endFrame();
+		std::swap(this->colorBuffer, this->backColorBuffer);
+	}
+
+	this->colorBufferCurrent = true;
+	this->renderPending = false;
+	return this->pendingFrameDrawn;
+}
+
+bool SoftwareRenderer::isRenderPending() const
+{
+	return this->renderPending;
+}
+
+void SoftwareRenderer::renderColumns(int startX, int endX)
+{
+	const Real widthReal = static_cast<Real>(this->width);
+	const Real one = static_cast<Real>(1.0);
+	const Real two = static_cast<Real>(2.0);
+
+	for (int x = startX; x < endX; ++x)
+	{
+		// X percent across the screen.
+		const Real xPercent = static_cast<Real>(x) / widthReal;
+
+		// "Right" component of the ray direction, based on current screen X.
+		const Real2 rightComp = this->frameRight2D *
+			(this->frameAspect * ((two * xPercent) - one));
+
+		// Calculate the ray direction through the pixel.
+		// - If un-normalized, it uses the Z distance, but the insides of voxels
+		//   don't look right then.
+		const Real2 direction = this->frameForwardComp + rightComp;
+
+		// Cast the 2D ray and fill in the column's wall pixels with color.
+		this->castRay(direction, *this->frameVoxelGrid, x);
+	}
+}
+
+void SoftwareRenderer::renderFlats(int startX, int endX, float *flatDepths)
+{
+	for (int x = startX; x < endX; ++x)
+	{
+		this->drawFlats(x, flatDepths);
+	}
+}
+
+void SoftwareRenderer::expandIndices(int startY, int endY,
+	const std::vector<int> *columnTiles)
+{
+	// The palette is small enough to stay in the L1 cache, so this is one table
+	// lookup per pixel (or a gather of eight with AVX2).
+	const uint32_t *palette = this->outputPalette.data();
+	for (int y = startY; y < endY; ++y)
+	{
+		const uint8_t *indexRow = this->indexBuffer.data() + (y * this->width);
+		uint32_t *row = this->outputPixels + (y * this->outputPitch);
+		if (columnTiles != nullptr)
+		{
+			for (const int tile : *columnTiles)
+			{
+				const int startX = tile * SoftwareRenderer::COLUMN_TILE_WIDTH;
+				const int endX = std::min(startX + SoftwareRenderer::COLUMN_TILE_WIDTH,
+					this->width);
+				Kernels::expandPalette(indexRow + startX, endX - startX, palette,
+					row + startX);
+			}
+		}
+		else
+		{
+			Kernels::expandPalette(indexRow, this->width, palette, row);
+		}
+	}
+}
+
+void SoftwareRenderer::renderPixels3D(int startX, int startY, int endX, int endY)
+{
+	const Real widthReal = static_cast<Real>(this->width);
+	const Real heightReal = static_cast<Real>(this->height);
+	const Real one = static_cast<Real>(1.0);
+	const Real two = static_cast<Real>(2.0);
+
+	// Each packet of rays is a block of pixels two rows tall, so the rays stay close
+	// together and mostly step through the same voxels.
+	const int packetSize = getRayPacketSize();
+	const int packetWidth = packetSize / 2;
+	Real3 directions[RayPacket::MAX_SIZE];
+	Real3 colors[RayPacket::MAX_SIZE];
+	int pixelIndices[RayPacket::MAX_SIZE];
+
+	for (int y = startY; y < endY; y += 2)
+	{
+		for (int x = startX; x < endX; x += packetWidth)
+		{
+			// Blocks at the edge of the rectangle have fewer rays.
+			int count = 0;
+			for (int i = 0; i < packetSize; ++i)
+			{
+				const int pixelX = x + (i % packetWidth);
+				const int pixelY = y + (i / packetWidth);
+				if ((pixelX < endX) && (pixelY < endY))
+				{
+					// X and Y percents across the screen.
+					const Real xPercent = static_cast<Real>(pixelX) / widthReal;
+					const Real yPercent = static_cast<Real>(pixelY) / heightReal;
+
+					// "Right" and "up" components of the ray direction.
+					const Real3 rightComp = this->frameRight *
+						(this->frameAspect * ((two * xPercent) - one));
+					const Real3 upComp = this->frameUp * ((two * yPercent) - one);
+
+					// Calculate the ray direction through the pixel.
+					// - If un-normalized, it uses the Z distance, but the insides of voxels
+					//   don't look right then.
+					directions[count] = (this->frameForwardComp3D + rightComp - upComp).normalized();
+					pixelIndices[count] = pixelX + (pixelY * this->outputPitch);
+					count++;
+				}
+			}
+
+			this->castRayPacket(directions, count, *this->frameVoxelGrid, colors);
+
+			// Convert to 0x00RRGGBB.
+			for (int i = 0; i < count; ++i)
+			{
+				this->outputPixels[pixelIndices[i]] = colors[i].clamped().toRGB();
+			}
+		}
+	}
+}
+
+bool SoftwareRenderer::screenRectCanSeeVoxels(int startX, int startY,
+	int endX, int endY) const
+{
+	const VoxelGrid &voxelGrid = *this->frameVoxelGrid;
+	const double voxelHeight = voxelGrid.getVoxelHeight();
+	const Real widthReal = static_cast<Real>(this->width);
+	const Real heightReal = static_cast<Real>(this->height);
+	const Real zero = static_cast<Real>(0.0);
+	const Real one = static_cast<Real>(1.0);
+	const Real two = static_cast<Real>(2.0);
+
+	// The un-normalized direction through a pixel is (forward + (right * a) - (up * b)),
+	// so every ray through the rectangle is inside the pyramid spanned by the rays
+	// through its corner pixels.
+	const Real minA = this->frameAspect *
+		((two * (static_cast<Real>(startX) / widthReal)) - one);
+	const Real maxA = this->frameAspect *
+		((two * (static_cast<Real>(endX - 1) / widthReal)) - one);
+	const Real minB = (two * (static_cast<Real>(startY) / heightReal)) - one;
+	const Real maxB = (two * (static_cast<Real>(endY - 1) / heightReal)) - one;
+
+	// The DDA stops once the corners of voxels pass the view distance, so rays reach
+	// a few voxels farther than that. Directions are normalized before casting, and
+	// the shortest un-normalized one (nearest the screen center) reaches the farthest
+	// along the pyramid.
+	const Real nearestA = std::min(std::max(zero, minA), maxA);
+	const Real nearestB = std::min(std::max(zero, minB), maxB);
+	const Real maxDistance = static_cast<Real>(
+		this->viewDistance + (4.0 * std::max(voxelHeight, 1.0)));
+	const Real scale = maxDistance / std::sqrt(this->frameForwardComp3D.lengthSquared() +
+		(nearestA * nearestA) + (nearestB * nearestB));
+
+	// Bounding box of the pyramid, relative to the eye.
+	Real3 minPoint;
+	Real3 maxPoint;
+	const Real cornerAs[] = { minA, maxA };
+	const Real cornerBs[] = { minB, maxB };
+	for (const Real a : cornerAs)
+	{
+		for (const Real b : cornerBs)
+		{
+			const Real3 corner = (this->frameForwardComp3D +
+				(this->frameRight * a) - (this->frameUp * b)) * scale;
+			minPoint = minPoint.componentMin(corner);
+			maxPoint = maxPoint.componentMax(corner);
+		}
+	}
+
+	// Voxels the box touches, clipped to the grid.
+	const Double3 &eye = this->eye;
+	const int minX = std::max(static_cast<int>(std::floor(eye.x + minPoint.x)), 0);
+	const int minY = std::max(static_cast<int>(
+		std::floor((eye.y + minPoint.y) / voxelHeight)), 0);
+	const int minZ = std::max(static_cast<int>(std::floor(eye.z + minPoint.z)), 0);
+	const int maxX = std::min(static_cast<int>(std::floor(eye.x + maxPoint.x)),
+		voxelGrid.getWidth() - 1);
+	const int maxY = std::min(static_cast<int>(
+		std::floor((eye.y + maxPoint.y) / voxelHeight)), voxelGrid.getHeight() - 1);
+	const int maxZ = std::min(static_cast<int>(std::floor(eye.z + maxPoint.z)),
+		voxelGrid.getDepth() - 1);
+
+	if ((minX > maxX) || (minY > maxY) || (minZ > maxZ))
+	{
+		return false;
+	}
+
+	return voxelGrid.hasSolidVoxels(minX, minY, minZ, maxX, maxY, maxZ);
+}
+
+void SoftwareRenderer::beginFrame(const VoxelGrid &voxelGrid, uint32_t *pixels, int pitch,
+	bool dirtyColumnsOnly)
+{
+	// The pitch of an ARGB8888 buffer is always a whole number of pixels.
+	assert((pitch % sizeof(uint32_t)) == 0);
+	this->outputPixels = pixels;
+	this->outputPitch = pitch / static_cast<int>(sizeof(uint32_t));
+
 	// Constants for screen dimensions.
 	const double widthReal = static_cast<double>(this->width);
 	const double heightReal = static_cast<double>(this->height);
@@ -934,8 +2711,13 @@ void SoftwareRenderer::render(const VoxelGrid &voxelGrid)
 
 	// Refresh transformation matrix (model matrix isn't required because it's just the
 	// identity matrix, and the near plane in the perspective matrix doesn't really matter).
-	Matrix4d view = Matrix4d::view(this->eye, this->forward, right, up);
-	Matrix4d projection = Matrix4d::perspective(this->fovY, aspect, 0.001, this->viewDistance);
+	// Points are made relative to the eye before being transformed, so the view matrix
+	// has no translation.
+	const RealMatrix4 view = RealMatrix4::view(Real3(), toReal(this->forward),
+		toReal(right), toReal(up));
+	const RealMatrix4 projection = RealMatrix4::perspective(static_cast<Real>(this->fovY),
+		static_cast<Real>(aspect), static_cast<Real>(0.001),
+		static_cast<Real>(this->viewDistance));
 	this->transform = projection * view;
 
 	// Constant camera values for 2D (camera elevation is this->forward.y).
@@ -947,119 +2729,319 @@ void SoftwareRenderer::render(const VoxelGrid &voxelGrid)
 
 	// Constant DDA-related values. The Y component also needs to take voxel height
 	// into account because voxel height is a level-dependent variable.
-	this->startCellReal = Double3(
+	const double voxelHeight = voxelGrid.getVoxelHeight();
+	const Double3 startCellReal(
 		std::floor(this->eye.x),
-		std::floor(this->eye.y / voxelGrid.getVoxelHeight()),
+		std::floor(this->eye.y / voxelHeight),
 		std::floor(this->eye.z));
 	this->startCell = Int3(
-		static_cast<int>(this->startCellReal.x),
-		static_cast<int>(this->startCellReal.y),
-		static_cast<int>(this->startCellReal.z));
+		static_cast<int>(startCellReal.x),
+		static_cast<int>(startCellReal.y),
+		static_cast<int>(startCellReal.z));
+
+	// Ray casting works relative to the start voxel, so single precision only has to
+	// hold the eye's place within it instead of a coordinate in the thousands.
+	this->eyeOffset = toReal(Double3(
+		this->eye.x - startCellReal.x,
+		this->eye.y - (startCellReal.y * voxelHeight),
+		this->eye.z - startCellReal.z));
+
+	// Rebuild all of the voxel grid's derived data (empty distances and occupancy)
+	// now if an edit made it stale, so the render threads only ever read it.
+	voxelGrid.getEmptyDistances();
+
+	// Values used by the render threads for 2.5D ray casting (see renderColumns()). 
+	// This is the cheaper form of ray casting (although still not very efficient), 
+	// and results in a "fake" 3D scene. They're stored in the renderer because a 
+	// frame might still be rendering after this method returns.
+	this->frameVoxelGrid = &voxelGrid;
+	this->frameForwardComp = toReal(forwardComp);
+	this->frameRight2D = toReal(right2D);
+	this->frameAspect = static_cast<Real>(aspect);
+
+	// Values for 3D ray casting instead (see renderPixels3D()). While this is far
+	// more expensive than 2.5D ray casting, it does allow the scene to be represented
+	// in true 3D instead of "fake" 3D.
+	this->frameForwardComp3D = toReal(this->forward * zoom);
+	this->frameRight = toReal(right);
+	this->frameUp = toReal(up);
+	this->frameFogColor = toReal(this->fogColor);
+
+	// Rebuild the fog table if the view distance or fog color changed.
+	if (this->fogTableDirty)
+	{
+		this->updateFogTable();
+	}
+
+	// Indexed frames are drawn to the index buffer and converted to the output pixels
+	// in a last pass.
+	this->frameIndexed = this->drawsIndices();
+	if (this->frameIndexed && (this->indexBuffer.size() != this->colorBuffer.size()))
+	{
+		this->indexBuffer.resize(this->colorBuffer.size());
+	}
+
+	// Column tiles to draw in 2.5D. The rest of the screen keeps the last frame.
+	const int columnTileCount = static_cast<int>(this->dirtyColumnTiles.size());
+	this->frameColumnTiles.clear();
+	for (int tile = 0; tile < columnTileCount; ++tile)
+	{
+		if (!dirtyColumnsOnly || this->dirtyColumnTiles[tile])
+		{
+			this->frameColumnTiles.push_back(tile);
+		}
+	}
+
+	// Clear the screen, or just the columns being drawn (this could potentially be
+	// multi-threaded). Rows might not be contiguous in an external frame buffer.
+	const auto clearStartTime = std::chrono::steady_clock::now();
+	const std::vector<int> *clearTiles = dirtyColumnsOnly ? &this->frameColumnTiles : nullptr;
+	if (this->frameIndexed)
+	{
+		fillFrameBuffer(this->indexBuffer.data(), this->width, this->height, this->width,
+			this->skyIndex, clearTiles, SoftwareRenderer::COLUMN_TILE_WIDTH);
+	}
+	else
+	{
+		fillFrameBuffer(pixels, this->width, this->height, this->outputPitch,
+			this->fogColor.toRGB(), clearTiles, SoftwareRenderer::COLUMN_TILE_WIDTH);
+	}
+
+	const auto clearEndTime = std::chrono::steady_clock::now();
 
-	// Output color buffer.
-	uint32_t *pixels = this->colorBuffer.data();
+	// An output palette change since the last frame means every row's indices are
+	// converted again, not just the column tiles being drawn.
+	const bool expandAllRows = !dirtyColumnsOnly || this->outputPaletteDirty;
 
-	// Lambda for rendering some rows of pixels using 3D ray casting. While this is 
-	// far more expensive than 2.5D ray casting, it does allow the scene to be 
-	// represented in true 3D instead of "fake" 3D.
-	/*auto renderRows = [this, &voxelGrid, widthReal, heightReal, aspect,
-		&forwardComp, &up, &right, pixels](int startY, int endY)
+	// Later changes are relative to this frame.
+	this->lastSceneState = this->getSceneState(voxelGrid);
+	this->sceneDirty = false;
+	this->outputPaletteDirty = false;
+	std::fill(this->dirtyColumnTiles.begin(), this->dirtyColumnTiles.end(), false);
+
+	// Erase the visible flats list and re-calculate them. Flats are only drawn by
+	// the 2.5D ray caster for now.
+	this->visibleFlats.clear();
+	auto visibleFlatsEndTime = clearEndTime;
+	if (!this->full3D)
 	{
-		for (int y = startY; y < endY; ++y)
+		this->updateVisibleFlats();
+		visibleFlatsEndTime = std::chrono::steady_clock::now();
+
+		// Sort the visible flat data farthest to nearest (this may be relevant for
+		// transparencies).
+		std::sort(this->visibleFlats.begin(), this->visibleFlats.end(),
+			[](const std::pair<const Flat*, Flat::ProjectionData> &a,
+				const std::pair<const Flat*, Flat::ProjectionData> &b)
 		{
-			// Y percent across the screen.
-			const double yPercent = static_cast<double>(y) / heightReal;
+			return std::min(a.second.leftZ, a.second.rightZ) >
+				std::min(b.second.leftZ, b.second.rightZ);
+		});
+	}
 
-			// "Up" component of the ray direction, based on current screen Y.
-			const Double3 upComp = up * ((2.0 * yPercent) - 1.0);
+	// Give each column tile the subset of flats it can see.
+	this->binVisibleFlats();
+
+	const auto flatSortEndTime = std::chrono::steady_clock::now();
+	const std::chrono::duration<double> clearTime = clearEndTime - clearStartTime;
+	const std::chrono::duration<double> visibleFlatsTime = visibleFlatsEndTime - clearEndTime;
+	const std::chrono::duration<double> flatSortTime = flatSortEndTime - visibleFlatsEndTime;
+	this->frameTiming.clearSeconds = clearTime.count();
+	this->frameTiming.visibleFlatsSeconds = visibleFlatsTime.count();
+	this->frameTiming.flatSortSeconds = flatSortTime.count();
+
+	// Wake the render threads. Instead of giving each thread one fixed block of the
+	// screen, columns are handed out in small tiles through a shared counter, so threads
+	// that finish early (i.e., facing a nearby wall) take work from the slower ones.
+	// Tiled 3D rendering hands out square tiles in rows instead.
+	const bool tiled = this->full3D && this->tiled3D;
+	const int tileWidth = tiled ? SoftwareRenderer::SCREEN_TILE_SIZE :
+		SoftwareRenderer::COLUMN_TILE_WIDTH;
+	const int tileHeight = tiled ? SoftwareRenderer::SCREEN_TILE_SIZE : this->height;
+	const int tileCountX = (this->width + tileWidth - 1) / tileWidth;
+	const int tileCountY = (this->height + tileHeight - 1) / tileHeight;
+	const int tileCount = this->full3D ? (tileCountX * tileCountY) :
+		static_cast<int>(this->frameColumnTiles.size());
+
+	// 2.5D frames are drawn in three passes through the same counter: walls by column
+	// tile, then floors and ceilings by row tile (they need every column's wall rows),
+	// then flats by column tile again (they stand in front of floors). When only some
+	// column tiles are drawn, floors and ceilings are done by those column tiles too.
+	// Indexed frames have a fourth pass that converts palette indices by row tile.
+	const int rowTileCount = this->full3D ? 0 : (dirtyColumnsOnly ? tileCount :
+		((this->height + SoftwareRenderer::FLOOR_ROW_TILE_HEIGHT - 1) /
+			SoftwareRenderer::FLOOR_ROW_TILE_HEIGHT));
+	const int flatTileStart = tileCount + rowTileCount;
+	const int expandTileStart = flatTileStart + tileCount;
+	const int expandTileCount = this->frameIndexed ?
+		((this->height + SoftwareRenderer::INDEX_ROW_TILE_HEIGHT - 1) /
+			SoftwareRenderer::INDEX_ROW_TILE_HEIGHT) : 0;
+	const int workCount = this->full3D ? tileCount : (expandTileStart + expandTileCount);
+	this->nextTile = 0;
+	this->finishedTiles = 0;
+
+	this->frameStartTime = std::chrono::steady_clock::now();
+	this->threadPool.start([this, tiled, tileWidth, tileHeight, tileCountX, tileCount,
+		flatTileStart, expandTileStart, workCount, dirtyColumnsOnly,
+		expandAllRows](int threadIndex)
+	{
+		ThreadTiming &timing = this->threadTimings[threadIndex];
+		float *flatDepths = this->flatDepthBuffers[threadIndex].data();
+		timing = ThreadTiming();
 
-			for (int x = 0; x < this->width; ++x)
+		int tile = this->nextTile.fetch_add(1);
+		while (tile < workCount)
+		{
+			// Tiles are claimed in order, so once as many tiles are finished as there
+			// are before this tile's pass, the previous pass is done.
+			const int passStart = (tile < tileCount) ? 0 :
+				((tile < flatTileStart) ? tileCount :
+				((tile < expandTileStart) ? flatTileStart : expandTileStart));
+			while (this->finishedTiles.load() < passStart)
 			{
-				// X percent across the screen.
-				const double xPercent = static_cast<double>(x) / widthReal;
+				std::this_thread::yield();
+			}
 
-				// "Right" component of the ray direction, based on current screen X.
-				const Double3 rightComp = right * (aspect * ((2.0 * xPercent) - 1.0));
+			const auto tileStartTime = std::chrono::steady_clock::now();
+			Profiler::Zone zone((passStart == 0) ? (this->full3D ? "3D tile" : "Wall tile") :
+				((passStart == tileCount) ? "Floor tile" :
+				((passStart == flatTileStart) ? "Flat tile" : "Expand tile")));
+
+			const int passTile = tile - passStart;
+			const bool expandTile = passStart == expandTileStart;
+			const bool rowTile = (passStart == tileCount) && !dirtyColumnsOnly;
+
+			// 2.5D column tiles only go through the ones being drawn.
+			const int screenTile = (this->full3D || rowTile || expandTile) ? passTile :
+				this->frameColumnTiles[passTile];
+			const int startX = (screenTile % tileCountX) * tileWidth;
+			const int startY = (screenTile / tileCountX) * tileHeight;
+			const int endX = std::min(startX + tileWidth, this->width);
+			const int endY = std::min(startY + tileHeight, this->height);
+			if (expandTile)
+			{
+				const int rowStart = passTile * SoftwareRenderer::INDEX_ROW_TILE_HEIGHT;
+				this->expandIndices(rowStart, std::min(
+					rowStart + SoftwareRenderer::INDEX_ROW_TILE_HEIGHT, this->height),
+					expandAllRows ? nullptr : &this->frameColumnTiles);
+			}
+			else if (rowTile)
+			{
+				const int rowStart = passTile * SoftwareRenderer::FLOOR_ROW_TILE_HEIGHT;
+				this->renderFloorRows(0, rowStart, this->width, std::min(
+					rowStart + SoftwareRenderer::FLOOR_ROW_TILE_HEIGHT, this->height));
+			}
+			else if (passStart == tileCount)
+			{
+				this->renderFloorRows(startX, 0, endX, this->height);
+			}
+			else if (passStart == flatTileStart)
+			{
+				this->renderFlats(startX, endX, flatDepths);
+			}
+			else if (tiled)
+			{
+				// Tiles whose rays can't reach a solid voxel are left as sky.
+				if (this->screenRectCanSeeVoxels(startX, startY, endX, endY))
+				{
+					this->renderPixels3D(startX, startY, endX, endY);
+				}
+			}
+			else if (this->full3D)
+			{
+				this->renderPixels3D(startX, startY, endX, endY);
+			}
+			else
+			{
+				this->renderColumns(startX, endX);
+			}
 
-				// Calculate the ray direction through the pixel.
-				// - If un-normalized, it uses the Z distance, but the insides of voxels
-				//   don't look right then.
-				const Double3 direction = (forwardComp + rightComp - upComp).normalized();
+			const std::chrono::duration<double> tileTime =
+				std::chrono::steady_clock::now() - tileStartTime;
+			timing.busySeconds += tileTime.count();
+			if (passStart == 0)
+			{
+				timing.wallSeconds += tileTime.count();
+			}
+			else if (passStart == tileCount)
+			{
+				timing.floorSeconds += tileTime.count();
+			}
+			else if (passStart == flatTileStart)
+			{
+				timing.flatSeconds += tileTime.count();
+			}
+			else
+			{
+				timing.expandSeconds += tileTime.count();
+			}
 
-				// Get the resulting color of the ray, starting from the eye.
-				const Double3 color = this->castRay(direction, voxelGrid);
+			timing.tileCount++;
+			this->finishedTiles.fetch_add(1);
 
-				// Convert to 0x00RRGGBB.
-				const int index = x + (y * this->width);
-				pixels[index] = color.clamped().toRGB();
-			}
+			tile = this->nextTile.fetch_add(1);
 		}
-	};*/
+	});
+}
 
-	// Lambda for rendering some columns of pixels using 2.5D ray casting. This is
-	// the cheaper form of ray casting (although still not very efficient), and results
-	// in a "fake" 3D scene.
-	auto renderColumns = [this, &voxelGrid, widthReal, aspect, &forwardComp,
-		&right2D](int startX, int endX)
+void SoftwareRenderer::beginPaletteFrame(uint32_t *pixels, int pitch)
+{
+	// The pitch of an ARGB8888 buffer is always a whole number of pixels.
+	assert((pitch % sizeof(uint32_t)) == 0);
+	assert(this->frameIndexed);
+	this->outputPixels = pixels;
+	this->outputPitch = pitch / static_cast<int>(sizeof(uint32_t));
+	this->outputPaletteDirty = false;
+
+	// Nothing is cleared or sorted. The only work is the last pass of an indexed
+	// frame, over every row tile.
+	this->frameTiming = FrameTiming();
+	const int expandTileCount = (this->height + SoftwareRenderer::INDEX_ROW_TILE_HEIGHT - 1) /
+		SoftwareRenderer::INDEX_ROW_TILE_HEIGHT;
+	this->nextTile = 0;
+
+	this->frameStartTime = std::chrono::steady_clock::now();
+	this->threadPool.start([this, expandTileCount](int threadIndex)
 	{
-		for (int x = startX; x < endX; ++x)
+		ThreadTiming &timing = this->threadTimings[threadIndex];
+		timing = ThreadTiming();
+
+		int tile = this->nextTile.fetch_add(1);
+		while (tile < expandTileCount)
 		{
-			// X percent across the screen.
-			const double xPercent = static_cast<double>(x) / widthReal;
+			const auto tileStartTime = std::chrono::steady_clock::now();
+			Profiler::Zone zone("Expand tile");
 
-			// "Right" component of the ray direction, based on current screen X.
-			const Double2 rightComp = right2D * (aspect * ((2.0 * xPercent) - 1.0));
+			const int rowStart = tile * SoftwareRenderer::INDEX_ROW_TILE_HEIGHT;
+			this->expandIndices(rowStart, std::min(
+				rowStart + SoftwareRenderer::INDEX_ROW_TILE_HEIGHT, this->height), nullptr);
 
-			// Calculate the ray direction through the pixel.
-			// - If un-normalized, it uses the Z distance, but the insides of voxels
-			//   don't look right then.
-			const Double2 direction = forwardComp + rightComp;
+			const std::chrono::duration<double> tileTime =
+				std::chrono::steady_clock::now() - tileStartTime;
+			timing.busySeconds += tileTime.count();
+			timing.expandSeconds += tileTime.count();
+			timing.tileCount++;
 
-			// Cast the 2D ray and fill in the column's pixels with color.
-			this->castRay(direction, voxelGrid, x);
+			tile = this->nextTile.fetch_add(1);
 		}
-	};
-
-	// Clear screen (this could potentially be multi-threaded).
-	const Double3 skyColor(0.40, 0.65, 1.0);
-	std::fill(this->colorBuffer.begin(), this->colorBuffer.end(), skyColor.toRGB());
-	std::fill(this->zBuffer.begin(), this->zBuffer.end(), std::numeric_limits<double>::infinity());
-
-	// Erase the visible flats list and re-calculate them.
-	this->visibleFlats.clear();
-	this->updateVisibleFlats();
-
-	// Sort the visible flat data farthest to nearest (this may be relevant for
-	// transparencies).
-	std::sort(this->visibleFlats.begin(), this->visibleFlats.end(),
-		[](const std::pair<const Flat*, Flat::ProjectionData> &a,
-			const std::pair<const Flat*, Flat::ProjectionData> &b)
-	{
-		return std::min(a.second.leftZ, a.second.rightZ) >
-			std::min(b.second.leftZ, b.second.rightZ);
 	});
+}
 
-	// Prepare render threads.
-	std::vector<std::thread> renderThreads(this->renderThreadCount);
+void SoftwareRenderer::endFrame()
+{
+	this->threadPool.wait();
 
-	// Start the render threads. "blockSize" is the approximate number of columns per thread.
-	// Rounding is involved so the start and stop coordinates are correct for all resolutions.
-	const double blockSize = widthReal / static_cast<double>(this->renderThreadCount);
-	for (int i = 0; i < this->renderThreadCount; ++i)
+	// Whatever part of the frame a thread wasn't rendering columns is idle time.
+	const std::chrono::duration<double> frameTime =
+		std::chrono::steady_clock::now() - this->frameStartTime;
+	for (auto &timing : this->threadTimings)
 	{
-		const int startX = static_cast<int>(std::round(static_cast<double>(i) * blockSize));
-		const int endX = static_cast<int>(std::round(static_cast<double>(i + 1) * blockSize));
-
-		// Make sure the rounding is correct.
-		assert(startX >= 0);
-		assert(endX <= this->width);
-
-		renderThreads[i] = std::thread(renderColumns, startX, endX);
+		timing.idleSeconds = std::max(frameTime.count() - timing.busySeconds, 0.0);
 	}
+}
 
-	// Wait for the render threads to finish.
-	for (auto &thread : renderThreads)
-	{
-		thread.join();
-	}
+void SoftwareRenderer::clearTimings()
+{
+	this->frameTiming = FrameTiming();
+	std::fill(this->threadTimings.begin(), this->threadTimings.end(), ThreadTiming());
 }
@@ -1,10 +1,13 @@
 #ifndef SOFTWARE_RENDERER_H
 #define SOFTWARE_RENDERER_H
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <unordered_map>
 #include <vector>
 
+#include "RenderThreadPool.h"
 #include "../Math/Matrix4.h"
 #include "../Math/Vector2.h"
 #include "../Math/Vector3.h"
@@ -21,11 +24,112 @@ class VoxelGrid;
 
 class SoftwareRenderer
 {
+public:
+	// Precision of the math done per column and per pixel. The public interface and
+	// world positions stay in double precision, and values near the camera are made
+	// relative to the eye's voxel, so single precision holds up anywhere in the world.
+	// Define SOFTWARE_RENDERER_FLOAT (the TESARENA_RENDERER_FLOAT CMake option) to use
+	// single precision.
+#ifdef SOFTWARE_RENDERER_FLOAT
+	typedef float Real;
+#else
+	typedef double Real;
+#endif
+
+	typedef Vector2f<Real> Real2;
+	typedef Vector3f<Real> Real3;
+	typedef Vector4f<Real> Real4;
+	typedef Matrix4<Real> RealMatrix4;
+
+	// Time spent by a render thread during the most recent frame. Busy time is spent 
+	// rendering tiles, and idle time is the rest of the frame (i.e., waiting for 
+	// other threads to finish).
+	struct ThreadTiming
+	{
+		double busySeconds, idleSeconds;
+		double wallSeconds, floorSeconds, flatSeconds; // Busy time in each 2.5D pass.
+		double expandSeconds; // Busy time converting palette indices (if indexed).
+		int tileCount; // Number of tiles rendered.
+
+		ThreadTiming() : busySeconds(0.0), idleSeconds(0.0), wallSeconds(0.0),
+			floorSeconds(0.0), flatSeconds(0.0), expandSeconds(0.0), tileCount(0) { }
+	};
+
+	// Time spent preparing the most recent frame on the calling thread before the
+	// render threads were woken.
+	struct FrameTiming
+	{
+		double clearSeconds;
+		double visibleFlatsSeconds;
+		double flatSortSeconds; // Sorting and binning the visible flats.
+
+		FrameTiming() : clearSeconds(0.0), visibleFlatsSeconds(0.0),
+			flatSortSeconds(0.0) { }
+	};
+
+	// How much of the last frame has to be drawn again for the next one.
+	enum class FrameChange
+	{
+		None, // The last frame can be shown again.
+		Palette, // Only the conversion of the last frame's palette indices to colors.
+		Columns, // Only column tiles under changed flats.
+		All
+	};
 private:
+	// Number of screen columns in each unit of work given to a render thread. 16 
+	// ARGB8888 pixels fill a 64-byte cache line, so threads don't share lines.
+	static const int COLUMN_TILE_WIDTH;
+
+	// Width and height in pixels of each unit of work in tiled 3D rendering. Nearby
+	// rays mostly step through the same voxels and texels, so square tiles keep more
+	// of them in cache than full columns.
+	static const int SCREEN_TILE_SIZE;
+
+	// Number of screen rows in each unit of floor and ceiling work given to a render
+	// thread.
+	static const int FLOOR_ROW_TILE_HEIGHT;
+
+	// Number of screen rows in each unit of palette index conversion given to a render
+	// thread. Whole rows are converted, since a column tile's rows are far apart.
+	static const int INDEX_ROW_TILE_HEIGHT;
+
+	// Number of distances from the eye to the view distance that the fog table is
+	// precomputed for. With 64, the table is 48 KB, so most of it stays in L2 next to
+	// the textures, and a fog step changes a color channel by at most about 4.
+	static const int FOG_LEVELS;
+
+	// Width and depth in voxels of each chunk in the flat spatial index.
+	static const int FLAT_CHUNK_SIZE;
+
+	// Number of low bits in a flat ID for the slot index. The remaining bits are the
+	// slot's generation.
+	static const int FLAT_SLOT_BITS;
+
+	// Smallest empty distance (see VoxelGrid) that ray casting skips over instead
+	// of stepping voxel by voxel. A skip costs about as much as several steps. It's
+	// at least the occupancy tile width, so only all-air tiles need to be checked.
+	static const int MIN_SKIP_EMPTY_DISTANCE;
+
+	// Axis of the voxel face that a 3D ray hit.
+	enum class FaceAxis { X, Y, Z };
+
+	// Initial DDA values of a 3D ray cast from the eye.
+	struct RayStart
+	{
+		Real3 deltaDist; // Distance between two sides along each axis.
+		Real3 sideDist; // Distance to the first side along each axis.
+		Int3 step; // Direction along each axis (-1 or 1).
+	};
+
 	struct TextureData
 	{
-		std::vector<Double4> pixels;
-		int width, height;
+		// ARGB8888 texels in column-major order (texel (x, y) is at x * height + y),
+		// since walls and flats are drawn one screen column at a time. Mip levels are
+		// stored after level 0, each half the size of the one before.
+		std::vector<uint32_t> pixels;
+		std::vector<uint8_t> indices; // Palette index of each texel, if there's a palette.
+		std::vector<int> levelOffsets; // Start of each mip level in the texels.
+		int width, height; // Dimensions of level 0.
 	};
 
 	// A flat is a 2D surface always facing perpendicular to the Y axis. It might be 
@@ -41,54 +145,298 @@ private:
 		{
 			// Four corners of the flat projected onto the viewing plane. These aren't 
 			// stored as 2-component vectors because there are some duplicates.
-			double leftX, rightX;
-			double topLeftY, topRightY, bottomLeftY, bottomRightY;
+			Real leftX, rightX;
+			Real topLeftY, topRightY, bottomLeftY, bottomRightY;
 
 			// Z-distances for left edge and right edge, for distance comparisons.
-			double leftZ, rightZ;
+			Real leftZ, rightZ;
 		};
 	};
 
+	// The wall depth in a screen column and the rows the wall covers. The 2.5D walls
+	// have one depth per column, so a per-pixel depth buffer isn't needed for them.
+	struct ColumnDepth
+	{
+		Real wallDepth; // Infinity if no wall was hit.
+		int wallStart, wallEnd; // Rows covered by the wall.
+	};
+
+	// Values that every pixel of a frame depends on. If any of them differ from the
+	// last frame's, the whole frame is drawn again.
+	struct SceneState
+	{
+		Double3 eye, forward, fogColor;
+		double fovY, viewDistance;
+		const VoxelGrid *voxelGrid;
+		int voxelRevision;
+		bool full3D;
+	};
+
+	// Maps a flat ID to the flat's place in the dense flat list. A slot's generation
+	// changes each time it's freed, so the IDs of removed flats stop matching.
+	struct FlatSlot
+	{
+		int index; // Index in the dense flat list, or -1 if the slot is free.
+		int generation;
+	};
+
+	// The IDs of flats whose position is within a square chunk of voxel columns, and
+	// the bounds those flats can reach. Bounds only grow while the chunk is in use,
+	// so they are conservative after a flat moves out.
+	struct FlatChunk
+	{
+		std::vector<int> flatIDs;
+		double minY, maxY; // Vertical range of the flats.
+		double maxHalfWidth; // How far a flat can extend outside the chunk's columns.
+	};
+
 	std::vector<uint32_t> colorBuffer;
-	std::vector<double> zBuffer;
-	std::unordered_map<int, Flat> flats;
+	std::vector<uint32_t> backColorBuffer; // Frame being rendered when pipelining.
+	uint32_t *outputPixels; // Frame buffer being drawn to (internal or external).
+	int outputPitch; // Pixels between the starts of two rows in the output.
+	std::vector<ColumnDepth> columnDepths; // One per screen column.
+	std::vector<std::vector<float>> flatDepthBuffers; // One column of flat depths per thread.
+	std::vector<Flat> flats; // Contiguous, in no particular order.
+	std::vector<int> flatIDs; // The ID of each flat in "flats".
+	std::vector<FlatSlot> flatSlots;
+	std::vector<int> freeFlatSlots; // Indices of slots that can be reused.
+	std::unordered_map<Int2, FlatChunk> flatChunks; // Spatial index for flats.
+	double maxFlatHalfWidth; // Largest half width of any flat added so far.
 	std::vector<std::pair<const Flat*, Flat::ProjectionData>> visibleFlats;
+	std::vector<std::vector<int>> visibleFlatBins; // Visible flat indices per column tile.
 	std::vector<TextureData> textures;
-	Matrix4d transform; // Transformation matrix for 3D point projection.
+	std::vector<uint8_t> fogTable; // Fogged R, G, and B values for each fog level.
+	std::vector<uint32_t> palette; // 0x00RRGGBB colors texels are matched to. Empty if none.
+	std::vector<uint32_t> outputPalette; // 0x00RRGGBB colors palette indices are shown as.
+	std::vector<uint8_t> shadeTable; // Fogged palette index of each index for each fog level.
+	std::vector<uint8_t> indexBuffer; // Palette indices of the frame in indexed rendering.
+	uint8_t skyIndex; // Palette index nearest to the fog color.
+	Double3 fogColor; // Also the sky color.
+	Real fogLevelsPerUnit; // Converts a distance to a fog level.
+	bool fogTableDirty; // True when the view distance or fog color has changed.
+	RealMatrix4 transform; // Projection * view, for points relative to the eye.
 	Double3 eye, forward; // Camera position and forward vector (forward.y used for Y-shearing).
-	Double3 startCellReal; // Initial voxel as a float type.
 	Int3 startCell; // Initial voxel for ray casting.
+	Real3 eyeOffset; // Eye position relative to the start voxel's minimum corner.
 	double fovY; // Vertical field of view.
 	double viewDistance; // Max render distance (usually at 100% fog).
-	double viewDistSquared; // For comparing with cell distance squared.
+	Real viewDistSquared; // For comparing with cell distance squared.
 	int width, height; // Dimensions of frame buffer.
-	int renderThreadCount; // Number of threads to use for rendering.
+	bool full3D; // Casts a 3D ray per pixel instead of a 2.5D ray per column.
+	bool tiled3D; // Splits 3D frames into square tiles instead of column tiles.
+	bool indexed; // Draws 2.5D frames as palette indices (see setIndexedRendering()).
+	RenderThreadPool threadPool; // Persistent worker threads for rendering.
+	std::vector<ThreadTiming> threadTimings; // One per render thread.
+
+	// Values for the frame the render threads are working on.
+	const VoxelGrid *frameVoxelGrid;
+	Real2 frameForwardComp, frameRight2D; // For generating 2D rays.
+	Real3 frameForwardComp3D, frameRight, frameUp; // For generating 3D rays.
+	Real3 frameFogColor;
+	Real frameAspect;
+	bool frameIndexed; // Drawing to the index buffer instead of the output pixels.
+	std::atomic<int> nextTile; // Next tile to be claimed by a render thread.
+	std::atomic<int> finishedTiles; // Tiles done so far, for starting the next pass.
+	std::vector<int> frameColumnTiles; // 2.5D column tiles being drawn this frame.
+	SceneState lastSceneState; // Scene state of the last frame drawn.
+	std::vector<bool> dirtyColumnTiles; // Column tiles that changed since the last frame.
+	bool sceneDirty; // True until the first frame and after new textures, palettes, or a resize.
+	bool outputPaletteDirty; // True if the output palette changed since the last indexed frame.
+	bool colorBufferCurrent; // True if the internal frame buffer has the last frame.
+	bool pendingFrameDrawn; // False if a pipelined frame just reuses the last one.
+	FrameTiming frameTiming;
+	std::chrono::steady_clock::time_point frameStartTime;
+	bool renderPending; // True between startRender() and finishRender().
+
+	// Gets the initial DDA values of a 3D ray cast from the eye.
+	RayStart getRayStart(const Real3 &direction, Real voxelHeight) const;
+
+	// Gets the color seen by a 3D ray that stopped in the given voxel, hitting the
+	// given face. A hit ID of zero means nothing was hit.
+	Real3 getRayColor(const Real3 &direction, const Int3 &cell, FaceAxis axis,
+		char hitID, const VoxelGrid &voxelGrid) const;
 
 	// Casts a 3D ray from the default start point (eye) and returns the color.
-	Double3 castRay(const Double3 &direction, const VoxelGrid &voxelGrid) const;
+	Real3 castRay(const Real3 &direction, const VoxelGrid &voxelGrid) const;
+
+	// Casts a packet of coherent 3D rays from the eye together, one per SIMD lane of
+	// the CPU's tier (see CPUFeatures), and writes their colors.
+	void castRayPacket(const Real3 *directions, int count, const VoxelGrid &voxelGrid,
+		Real3 *colors) const;
+
+	// Casts a 2D ray from the default start point (eye), writes wall color into
+	// the given column, and saves the column's wall depth and rows.
+	void castRay(const Real2 &direction, const VoxelGrid &voxelGrid, int x);
 
-	// Casts a 2D ray from the default start point (eye) and writes color into
-	// the given column.
-	void castRay(const Double2 &direction, const VoxelGrid &voxelGrid, int x);
+	// Draws the visible flats in a column over its walls, floor, and ceiling. The
+	// flat depth buffer is scratch space for one column.
+	void drawFlats(int x, float *flatDepths);
+
+	// Gets the mip level of a texture to sample when one screen pixel covers the given
+	// number of level 0 texels. Level 0 is used for magnification.
+	static int getMipLevel(const TextureData &texture, Real texelsPerPixel);
+
+	// Gets the palette index whose color is nearest to a 0x00RRGGBB color.
+	uint8_t getNearestPaletteIndex(uint32_t color) const;
+
+	// Fills in the palette indices of a texture's texels (mip levels included).
+	void updateTextureIndices(TextureData &texture) const;
+
+	// Recalculates the fog table (and the shade table in indexed rendering) for the
+	// current view distance and fog color.
+	void updateFogTable();
+
+	// Gets the fog level for a distance from the eye.
+	int getFogLevel(Real distance) const;
+
+	// Gets the 3 * 256 fogged channel values (R, G, B) for a distance from the eye.
+	const uint8_t *getFogTableRow(Real distance) const;
+
+	// Gets the 256 fogged palette indices for a distance from the eye.
+	const uint8_t *getShadeTableRow(Real distance) const;
+
+	// Gets the index of a flat in the dense flat list, or -1 if no flat has the ID.
+	int getFlatIndex(int id) const;
+
+	// Gets the coordinate of the flat chunk containing the given position.
+	static Int2 getFlatChunkCoord(const Double3 &position);
+
+	// Adds or removes a flat ID from the chunk at the flat's position.
+	void addFlatToChunk(int id, const Flat &flat);
+	void removeFlatFromChunk(int id, const Flat &flat);
+
+	// Returns whether the bounds of a flat chunk might intersect the viewing frustum.
+	bool flatChunkIsVisible(const Int2 &coord, const FlatChunk &chunk) const;
+
+	// Transforms a world point by the current transform. The point is made relative to
+	// the eye in double precision first.
+	Real4 transformPoint(const Double3 &point) const;
+
+	// Projects a flat with the current transform. Returns whether it's on-screen.
+	bool projectFlat(const Flat &flat, Flat::ProjectionData &projectionData) const;
+
+	// Gets the first and last column tiles that a projected flat might touch.
+	void getFlatColumnTiles(const Flat::ProjectionData &projectionData,
+		int &startTile, int &endTile) const;
+
+	// Marks the column tiles under a flat as needing to be drawn again. Called with
+	// the flat before and after it changes, since the last frame's transform is
+	// still current if nothing else changed.
+	void markFlatDirty(const Flat &flat);
+
+	// Projects a flat and adds it to the visible flats if it's on-screen.
+	void addVisibleFlat(const Flat &flat);
+
+	// Casts 2D rays for a range of screen columns with the current frame's values.
+	void renderColumns(int startX, int endX);
+
+	// Draws the floor and ceiling next to the eye's voxel level in a rectangle of the
+	// screen, one horizontal span at a time, skipping the rows covered by each column's
+	// wall. Every column must have been ray cast first. The max values are exclusive.
+	void renderFloorRows(int startX, int startY, int endX, int endY);
+
+	// Draws flats in a range of screen columns after their walls, floors, and ceilings.
+	void renderFlats(int startX, int endX, float *flatDepths);
+
+	// Converts the palette indices in a range of screen rows to output pixels, only in
+	// the column tiles being drawn if given. The max value is exclusive.
+	void expandIndices(int startY, int endY, const std::vector<int> *columnTiles);
+
+	// Casts 3D rays for every pixel in a rectangle of the screen with the current
+	// frame's values. The max values are exclusive.
+	void renderPixels3D(int startX, int startY, int endX, int endY);
+
+	// Returns whether any 3D ray through a rectangle of the screen might reach a
+	// solid voxel, using the bounding box of the rectangle's view frustum. The max
+	// values are exclusive.
+	bool screenRectCanSeeVoxels(int startX, int startY, int endX, int endY) const;
+
+	// Gets the values that the next frame depends on.
+	SceneState getSceneState(const VoxelGrid &voxelGrid) const;
+
+	// Returns whether 2.5D frames are drawn as palette indices right now.
+	bool drawsIndices() const;
+
+	// Prepares a frame for the given output buffer and wakes the render threads.
+	// The pitch is in bytes. If only drawing dirty column tiles, the buffer must
+	// already have the last frame.
+	void beginFrame(const VoxelGrid &voxelGrid, uint32_t *pixels, int pitch,
+		bool dirtyColumnsOnly);
+
+	// Wakes the render threads to only convert the index buffer's last frame to the
+	// given output buffer with the output palette. The pitch is in bytes.
+	void beginPaletteFrame(uint32_t *pixels, int pitch);
+
+	// Waits for the render threads to finish the frame and updates thread timings.
+	void endFrame();
+
+	// Sets the frame and thread timings to zero for a frame that reuses the last one.
+	void clearTimings();
 
 	// Refreshes the list of flats that are within the viewing frustum.
 	void updateVisibleFlats();
+
+	// Sorts the visible flats into bins by which column tiles they overlap. Each bin
+	// keeps the order of the visible flats (farthest to nearest).
+	void binVisibleFlats();
 public:
-	SoftwareRenderer(int width, int height);
+	// If the render thread count is zero, one thread per hardware thread is used.
+	SoftwareRenderer(int width, int height, int renderThreadCount, bool pinRenderThreads);
 	~SoftwareRenderer();
 
 	// Gets a pointer to the frame buffer's pixels in ARGB8888 format.
 	// Intended for writing to a separate hardware texture with.
 	const uint32_t *getPixels() const;
 
+	// Gets the busy and idle time of each render thread for the most recent frame.
+	// 3D tiles count as wall time.
+	const std::vector<ThreadTiming> &getThreadTimings() const;
+
+	// Gets the time spent preparing the most recent frame.
+	const FrameTiming &getFrameTiming() const;
+
+	// Gets the name of the precision the renderer was compiled with (see Real).
+	static const char *getPrecisionName();
+
 	// Methods for setting various camera values.
 	void setEye(const Double3 &eye);
 	void setForward(const Double3 &forward);
 	void setFovY(double fovY);
 	void setViewDistance(double viewDistance);
 
-	// Adds a texture and returns its assigned ID (index).
-	int addTexture(const uint32_t *pixels, int width, int height);
+	// Sets the color that distant geometry fades to, which is also the sky color.
+	void setFogColor(const Double3 &fogColor);
+
+	// Sets whether every pixel is ray cast in true 3D. This is much more expensive 
+	// than the default 2.5D ray casting, and flats aren't drawn yet.
+	void setFull3D(bool full3D);
+
+	// Sets whether 3D frames are split into square tiles of pixels for the render
+	// threads instead of columns. Tiles whose view frustum doesn't reach any solid
+	// voxels are skipped. Has no effect on 2.5D rendering.
+	void setTiled3D(bool tiled3D);
+
+	// Sets the 256 colors (ARGB8888) for indexed rendering. Texels are matched to
+	// their nearest color, so this is for loading a new palette, not for palette
+	// effects. The output palette is set to the same colors.
+	void setPalette(const uint32_t *colors);
+
+	// Sets the 256 colors (ARGB8888) that the palette indices of a frame are shown as,
+	// without matching the texels again (i.e., for flashes and fades). The next frame
+	// only converts the last frame's indices again if nothing else changed. Does
+	// nothing unless frames are drawn as palette indices (see setIndexedRendering()).
+	void setOutputPalette(const uint32_t *colors);
+
+	// Sets whether 2.5D frames are drawn as 8-bit palette indices and converted to
+	// ARGB8888 in a final pass. That writes a quarter of the bytes,
+	// but fog is quantized to the nearest palette color. Has no effect without a
+	// palette, or in full 3D.
+	void setIndexedRendering(bool indexed);
+
+	// Adds a texture and returns its assigned ID (index). Mipmapped textures get
+	// smaller copies for drawing at a distance. Textures that are always drawn near
+	// full size (i.e., UI-style) don't need them.
+	int addTexture(const uint32_t *pixels, int width, int height, bool mipmapped);
 
 	// Adds a flat and returns its assigned ID.
 	int addFlat(const Double3 &position, const Double2 &direction, double width,
@@ -105,8 +453,33 @@ public:
 	// Resizes the frame buffer and related values.
 	void resize(int width, int height);
 
-	// Draws the scene to the internal frame buffer.
+	// Gets how much of the last frame has to be drawn again. Nothing does if the
+	// camera, view distance, fog, voxels, flats, textures, and output palette haven't
+	// changed, so the caller can show the last frame again (i.e., while the player
+	// stands still).
+	FrameChange getFrameChange(const VoxelGrid &voxelGrid) const;
+
+	// Draws the scene to the internal frame buffer. Only the parts that changed since
+	// the last frame are drawn (see getFrameChange()).
 	void render(const VoxelGrid &voxelGrid);
+
+	// Draws the whole scene to an external ARGB8888 frame buffer of the same dimensions
+	// (i.e., a locked streaming texture). The pitch is in bytes, like SDL's. The
+	// internal frame buffer is not updated.
+	void render(const VoxelGrid &voxelGrid, uint32_t *pixels, int pitch);
+
+	// Pipelined rendering. startRender() wakes the render threads to draw the scene
+	// into a back buffer and returns right away, so the caller can do other work
+	// (i.e., upload the previous frame). finishRender() waits for them and makes
+	// the new frame available through getPixels(). Like render(), only the parts that
+	// changed are drawn. Nothing else in the renderer may be changed in between.
+	// finishRender() returns false if nothing changed and getPixels() still has the
+	// same frame as before.
+	void startRender(const VoxelGrid &voxelGrid);
+	bool finishRender();
+
+	// Returns whether a frame was started with startRender() and not yet finished.
+	bool isRenderPending() const;
 };
 
 #endif
@@ -0,0 +1,117 @@
+#include "CPUFeatures.h"
+
+#if defined(CPU_FEATURES_X86) && defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+std::atomic<int> CPUFeatures::forcedTier(-1);
+
+CPUFeatures::Tier CPUFeatures::detectTier()
+{
+#if defined(CPU_FEATURES_X86) && (defined(__GNUC__) || defined(__clang__))
+	// The builtin also checks that the OS saves AVX registers.
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+	{
+		return Tier::AVX2;
+	}
+	else if (__builtin_cpu_supports("sse2"))
+	{
+		return Tier::SSE2;
+	}
+	else
+	{
+		return Tier::Scalar;
+	}
+#elif defined(CPU_FEATURES_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	const int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	const bool hasSSE2 = (info[3] & (1 << 26)) != 0;
+	const bool hasAVX = (info[2] & (1 << 28)) != 0;
+	const bool hasOSXSave = (info[2] & (1 << 27)) != 0;
+
+	// AVX2 registers are only usable if the OS saves them on a context switch.
+	bool hasAVX2 = false;
+	if (hasAVX && hasOSXSave && (maxLeaf >= 7))
+	{
+		const bool osSavesYMM = (_xgetbv(0) & 0x6) == 0x6;
+		__cpuidex(info, 7, 0);
+		hasAVX2 = osSavesYMM && ((info[1] & (1 << 5)) != 0);
+	}
+
+	if (hasAVX2)
+	{
+		return Tier::AVX2;
+	}
+	else if (hasSSE2)
+	{
+		return Tier::SSE2;
+	}
+	else
+	{
+		return Tier::Scalar;
+	}
+#else
+	return Tier::Scalar;
+#endif
+}
+
+CPUFeatures::Tier CPUFeatures::getDetectedTier()
+{
+	// Detected once, the first time it's needed.
+	static const Tier detectedTier = CPUFeatures::detectTier();
+	return detectedTier;
+}
+
+CPUFeatures::Tier CPUFeatures::getTier()
+{
+	const int tier = CPUFeatures::forcedTier.load(std::memory_order_relaxed);
+	return (tier >= 0) ? static_cast<Tier>(tier) : CPUFeatures::getDetectedTier();
+}
+
+void CPUFeatures::setTier(Tier tier)
+{
+	const Tier detectedTier = CPUFeatures::getDetectedTier();
+	const Tier usedTier = (static_cast<int>(tier) <= static_cast<int>(detectedTier)) ?
+		tier : detectedTier;
+	CPUFeatures::forcedTier.store(static_cast<int>(usedTier), std::memory_order_relaxed);
+}
+
+void CPUFeatures::resetTier()
+{
+	CPUFeatures::forcedTier.store(-1, std::memory_order_relaxed);
+}
+
+const char *CPUFeatures::getTierName(Tier tier)
+{
+	switch (tier)
+	{
+	case Tier::Scalar:
+		return "Scalar";
+	case Tier::SSE2:
+		return "SSE2";
+	case Tier::AVX2:
+		return "AVX2";
+	default:
+		return "Unknown";
+	}
+}
+
+bool CPUFeatures::tryParseTier(const std::string &name, Tier &tier)
+{
+	const Tier tiers[] = { Tier::Scalar, Tier::SSE2, Tier::AVX2 };
+	for (const Tier candidate : tiers)
+	{
+		if (name == CPUFeatures::getTierName(candidate))
+		{
+			tier = candidate;
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,63 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#include <atomic>
+#include <string>
+
+// Picks which variant of a hot loop to run (i.e., filling a wall column or expanding
+// palette indices) from the SIMD instructions the CPU supports, so one build can use
+// AVX2 on newer CPUs and still run on SSE2-only ones. Support is detected once, and
+// a lower tier can be forced for testing and benchmarking.
+
+// Only x86 builds have SSE2 and AVX2 variants.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CPU_FEATURES_X86
+#endif
+
+// GCC and Clang only allow SIMD intrinsics in functions marked with their target when
+// the rest of the build doesn't target it. MSVC allows them anywhere.
+#if defined(CPU_FEATURES_X86) && (defined(__GNUC__) || defined(__clang__))
+#define CPU_FEATURES_TARGET_SSE2 __attribute__((target("sse2")))
+#define CPU_FEATURES_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define CPU_FEATURES_TARGET_SSE2
+#define CPU_FEATURES_TARGET_AVX2
+#endif
+
+class CPUFeatures
+{
+public:
+	// Each tier includes the ones before it.
+	enum class Tier { Scalar, SSE2, AVX2 };
+private:
+	CPUFeatures() = delete;
+	CPUFeatures(const CPUFeatures&) = delete;
+	~CPUFeatures() = delete;
+
+	// Forced tier, or -1 to use the detected one.
+	static std::atomic<int> forcedTier;
+
+	// Asks the CPU (and OS, for AVX2 registers) which tier is supported.
+	static Tier detectTier();
+public:
+	// Gets the highest tier the CPU supports.
+	static Tier getDetectedTier();
+
+	// Gets the tier that kernels should use.
+	static Tier getTier();
+
+	// Forces kernels to use a tier. A tier the CPU doesn't support is lowered to the
+	// detected one. It should be set before any rendering or loading starts.
+	static void setTier(Tier tier);
+
+	// Goes back to using the detected tier.
+	static void resetTier();
+
+	// Gets the name of a tier (i.e., "AVX2").
+	static const char *getTierName(Tier tier);
+
+	// Gets the tier with the given name. Returns whether the name matched a tier.
+	static bool tryParseTier(const std::string &name, Tier &tier);
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <cassert>
+
+#include "FrameTimings.h"
+
+#include "Debug.h"
+
+FrameTimings::Scope::Scope(FrameTimings &frameTimings, const char *stageName)
+	: frameTimings(frameTimings), stageName(stageName), zone(stageName)
+{
+	this->startTime = std::chrono::steady_clock::now();
+}
+
+FrameTimings::Scope::~Scope()
+{
+	const std::chrono::duration<double> time =
+		std::chrono::steady_clock::now() - this->startTime;
+	this->frameTimings.addTime(this->stageName, time.count());
+}
+
+FrameTimings::FrameTimings()
+{
+	this->frameStartTime = std::chrono::steady_clock::now();
+	this->lastFrameSeconds = 0.0;
+	this->frameNumber = 0;
+}
+
+FrameTimings::~FrameTimings()
+{
+
+}
+
+int FrameTimings::getStageIndex(const std::string &stageName)
+{
+	// There are only a couple dozen stages, so a linear search is fine.
+	const auto iter = std::find(this->stageNames.begin(), this->stageNames.end(), stageName);
+	if (iter != this->stageNames.end())
+	{
+		return static_cast<int>(iter - this->stageNames.begin());
+	}
+
+	this->stageNames.push_back(stageName);
+	this->stageSeconds.push_back(0.0);
+	this->lastStageSeconds.push_back(0.0);
+	return static_cast<int>(this->stageNames.size()) - 1;
+}
+
+int FrameTimings::getStageCount() const
+{
+	return static_cast<int>(this->stageNames.size());
+}
+
+const std::string &FrameTimings::getStageName(int index) const
+{
+	assert(index >= 0);
+	assert(index < this->getStageCount());
+	return this->stageNames[index];
+}
+
+double FrameTimings::getStageSeconds(int index) const
+{
+	assert(index >= 0);
+	assert(index < this->getStageCount());
+	return this->lastStageSeconds[index];
+}
+
+double FrameTimings::getFrameSeconds() const
+{
+	return this->lastFrameSeconds;
+}
+
+void FrameTimings::addTime(const std::string &stageName, double seconds)
+{
+	const int index = this->getStageIndex(stageName);
+	this->stageSeconds[index] += seconds;
+}
+
+void FrameTimings::setCSVPath(const std::string &path)
+{
+	if (this->csvStream.is_open())
+	{
+		this->csvStream.close();
+	}
+
+	if (path.size() > 0)
+	{
+		// Timings are only for diagnostics, so the game keeps going without them.
+		this->csvStream.open(path.c_str(), std::ios::out | std::ios::trunc);
+		if (this->csvStream.is_open())
+		{
+			this->csvStream << "Frame,Stage,Milliseconds\n";
+		}
+		else
+		{
+			Debug::mention("Frame Timings", "Could not open \"" + path + "\".");
+		}
+	}
+}
+
+void FrameTimings::endFrame()
+{
+	const auto frameEndTime = std::chrono::steady_clock::now();
+	const std::chrono::duration<double> frameTime = frameEndTime - this->frameStartTime;
+	this->lastFrameSeconds = frameTime.count();
+	this->frameStartTime = frameEndTime;
+
+	if (this->csvStream.is_open())
+	{
+		// One row per stage keeps the columns the same when stages are added later
+		// (i.e., once the game world is first drawn).
+		for (size_t i = 0; i < this->stageNames.size(); ++i)
+		{
+			this->csvStream << this->frameNumber << ',' << this->stageNames[i] << ',' <<
+				(this->stageSeconds[i] * 1000.0) << '\n';
+		}
+
+		this->csvStream << this->frameNumber << ",Frame," <<
+			(this->lastFrameSeconds * 1000.0) << '\n';
+	}
+
+	std::swap(this->stageSeconds, this->lastStageSeconds);
+	std::fill(this->stageSeconds.begin(), this->stageSeconds.end(), 0.0);
+	this->frameNumber++;
+}
@@ -0,0 +1,75 @@
+#ifndef FRAME_TIMINGS_H
+#define FRAME_TIMINGS_H
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Profiler.h"
+
+// Keeps how long each stage of a frame took (ray casting, texture upload, etc.), so
+// it can be shown on-screen or written to a CSV file to see where a frame's time
+// goes. Stages are named by the caller and kept in the order they were first timed.
+
+// Times from the most recent finished frame are the ones that are read. A stage that
+// wasn't timed during a frame (i.e., the game world wasn't redrawn) has zero time.
+
+class FrameTimings
+{
+public:
+	// Adds the time between its construction and destruction to a stage. It's also
+	// a profiler zone, so stages show up in traces. The name should be a string
+	// literal.
+	class Scope
+	{
+	private:
+		FrameTimings &frameTimings;
+		const char *stageName;
+		Profiler::Zone zone;
+		std::chrono::steady_clock::time_point startTime;
+	public:
+		Scope(FrameTimings &frameTimings, const char *stageName);
+		~Scope();
+	};
+private:
+	std::vector<std::string> stageNames;
+	std::vector<double> stageSeconds; // Frame in progress.
+	std::vector<double> lastStageSeconds; // Most recent finished frame.
+	std::ofstream csvStream;
+	std::chrono::steady_clock::time_point frameStartTime;
+	double lastFrameSeconds;
+	int frameNumber; // Number of finished frames.
+
+	// Gets the index of a stage, adding it if it's new.
+	int getStageIndex(const std::string &stageName);
+public:
+	FrameTimings();
+	~FrameTimings();
+
+	// Gets the number of stages timed so far.
+	int getStageCount() const;
+
+	// Gets the name of a stage.
+	const std::string &getStageName(int index) const;
+
+	// Gets the time spent in a stage during the most recent finished frame.
+	double getStageSeconds(int index) const;
+
+	// Gets the time between the ends of the two most recent finished frames,
+	// including any frame rate limiting.
+	double getFrameSeconds() const;
+
+	// Adds time to a stage of the frame in progress.
+	void addTime(const std::string &stageName, double seconds);
+
+	// Starts writing each finished frame to a CSV file with one row per stage
+	// (frame number, stage name, milliseconds). An empty path stops writing.
+	void setCSVPath(const std::string &path);
+
+	// Finishes the frame in progress, writing it to the CSV file if there is one,
+	// and starts the next frame.
+	void endFrame();
+};
+
+#endif
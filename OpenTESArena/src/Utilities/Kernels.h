@@ -0,0 +1,26 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <cstdint>
+
+// Loops over pixel spans that are used by both asset loading and rendering. Each one
+// runs the variant for the tier chosen by CPUFeatures, and every variant gives the
+// same result.
+
+class Kernels
+{
+private:
+	Kernels() = delete;
+	Kernels(const Kernels&) = delete;
+	~Kernels() = delete;
+public:
+	// Sets each pixel in a span to the same value.
+	static void fill(uint32_t *dst, int count, uint32_t value);
+
+	// Writes the color of each 8-bit palette index in a span. The colors array must
+	// have 256 entries.
+	static void expandPalette(const uint8_t *indices, int count,
+		const uint32_t *colors, uint32_t *dst);
+};
+
+#endif
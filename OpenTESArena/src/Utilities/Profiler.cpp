@@ -0,0 +1,186 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Profiler.h"
+
+#include "Debug.h"
+
+namespace
+{
+	struct ProfilerEvent
+	{
+		const char *name;
+		int64_t startTime, endTime; // In nanoseconds.
+	};
+
+	// Zones recorded by one thread. The mutex is only contended while a trace is
+	// being written.
+	struct ProfilerThreadBuffer
+	{
+		std::mutex mutex;
+		std::vector<ProfilerEvent> events; // Ring buffer, allocated on the first zone.
+		uint64_t eventCount; // Total zones recorded, including overwritten ones.
+		std::string name;
+		int id;
+	};
+
+	const std::chrono::steady_clock::time_point ProfilerStartTime =
+		std::chrono::steady_clock::now();
+
+	// Buffers are never freed, so zones from threads that have exited can still be
+	// written.
+	std::mutex ProfilerThreadBuffersMutex;
+	std::vector<std::unique_ptr<ProfilerThreadBuffer>> ProfilerThreadBuffers;
+	thread_local ProfilerThreadBuffer *CurrentProfilerThreadBuffer = nullptr;
+
+	ProfilerThreadBuffer &getCurrentThreadBuffer()
+	{
+		if (CurrentProfilerThreadBuffer == nullptr)
+		{
+			std::unique_ptr<ProfilerThreadBuffer> buffer(new ProfilerThreadBuffer());
+			buffer->eventCount = 0;
+
+			std::lock_guard<std::mutex> lock(ProfilerThreadBuffersMutex);
+			buffer->id = static_cast<int>(ProfilerThreadBuffers.size());
+			buffer->name = "Thread " + std::to_string(buffer->id);
+			CurrentProfilerThreadBuffer = buffer.get();
+			ProfilerThreadBuffers.push_back(std::move(buffer));
+		}
+
+		return *CurrentProfilerThreadBuffer;
+	}
+
+	// Escapes a string for use in JSON.
+	std::string escapeJSON(const std::string &str)
+	{
+		std::string escaped;
+		for (const char c : str)
+		{
+			if ((c == '"') || (c == '\\'))
+			{
+				escaped.push_back('\\');
+				escaped.push_back(c);
+			}
+			else if (static_cast<unsigned char>(c) < 0x20)
+			{
+				char buffer[8];
+				std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+				escaped += buffer;
+			}
+			else
+			{
+				escaped.push_back(c);
+			}
+		}
+
+		return escaped;
+	}
+}
+
+const int Profiler::EVENTS_PER_THREAD = 1 << 16;
+
+std::atomic<bool> Profiler::enabled(false);
+
+int64_t Profiler::getTime()
+{
+	const auto time = std::chrono::steady_clock::now() - ProfilerStartTime;
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+}
+
+void Profiler::addEvent(const char *name, int64_t startTime, int64_t endTime)
+{
+	ProfilerThreadBuffer &buffer = getCurrentThreadBuffer();
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	if (buffer.events.size() == 0)
+	{
+		buffer.events.resize(Profiler::EVENTS_PER_THREAD);
+	}
+
+	ProfilerEvent &event = buffer.events[buffer.eventCount % buffer.events.size()];
+	event.name = name;
+	event.startTime = startTime;
+	event.endTime = endTime;
+	buffer.eventCount++;
+}
+
+bool Profiler::isEnabled()
+{
+	return Profiler::enabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+	Profiler::enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::setThreadName(const std::string &name)
+{
+	ProfilerThreadBuffer &buffer = getCurrentThreadBuffer();
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	buffer.name = name;
+}
+
+bool Profiler::writeTrace(const std::string &filename)
+{
+	std::ofstream ofs(filename.c_str(), std::ios::out | std::ios::trunc);
+	if (!ofs.is_open())
+	{
+		Debug::mention("Profiler", "Could not open \"" + filename + "\".");
+		return false;
+	}
+
+	// Times in a trace are in microseconds.
+	auto writeMicroseconds = [&ofs](int64_t nanoseconds)
+	{
+		char buffer[32];
+		std::snprintf(buffer, sizeof(buffer), "%.3f",
+			static_cast<double>(nanoseconds) / 1000.0);
+		ofs << buffer;
+	};
+
+	ofs << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	bool firstEvent = true;
+	std::lock_guard<std::mutex> buffersLock(ProfilerThreadBuffersMutex);
+	for (const auto &bufferPtr : ProfilerThreadBuffers)
+	{
+		ProfilerThreadBuffer &buffer = *bufferPtr.get();
+		std::lock_guard<std::mutex> lock(buffer.mutex);
+
+		// Thread names are metadata events.
+		ofs << (firstEvent ? "\n" : ",\n");
+		ofs << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer.id <<
+			",\"args\":{\"name\":\"" << escapeJSON(buffer.name) << "\"}}";
+		firstEvent = false;
+
+		// Write the kept zones oldest to newest.
+		const uint64_t capacity = static_cast<uint64_t>(buffer.events.size());
+		const uint64_t firstIndex = (buffer.eventCount > capacity) ?
+			(buffer.eventCount - capacity) : 0;
+		for (uint64_t i = firstIndex; i < buffer.eventCount; ++i)
+		{
+			const ProfilerEvent &event = buffer.events[i % capacity];
+			ofs << ",\n{\"name\":\"" << escapeJSON(event.name) <<
+				"\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer.id << ",\"ts\":";
+			writeMicroseconds(event.startTime);
+			ofs << ",\"dur\":";
+			writeMicroseconds(event.endTime - event.startTime);
+			ofs << "}";
+		}
+	}
+
+	ofs << "\n]}\n";
+
+	if (!ofs.good())
+	{
+		Debug::mention("Profiler", "Could not write \"" + filename + "\".");
+		return false;
+	}
+
+	Debug::mention("Profiler", "Wrote \"" + filename + "\".");
+	return true;
+}
@@ -0,0 +1,81 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// A zone profiler for finding stalls on a timeline (i.e., a palette load in the
+// middle of gameplay, or a slow .FLC decode). Each thread records the start and end
+// of named zones in its own ring buffer, and the most recent zones of every thread
+// can be written as a Chrome trace_event JSON file for chrome://tracing or Perfetto.
+
+// It's off by default. A disabled zone only checks one flag, so zones can be left
+// in hot code like the render threads' tile loop.
+
+class Profiler
+{
+public:
+	// Records the time between its construction and destruction as a zone on the
+	// calling thread. The name isn't copied, so it should be a string literal.
+	class Zone
+	{
+	private:
+		const char *name;
+		int64_t startTime; // In nanoseconds. Negative if the profiler was disabled.
+	public:
+		Zone(const char *name);
+		Zone(const Zone&) = delete;
+		~Zone();
+
+		Zone &operator=(const Zone&) = delete;
+	};
+private:
+	Profiler() = delete;
+	Profiler(const Profiler&) = delete;
+	~Profiler() = delete;
+
+	// Number of zones each thread keeps. Older zones are overwritten.
+	static const int EVENTS_PER_THREAD;
+
+	static std::atomic<bool> enabled;
+
+	// Gets the time in nanoseconds since the program started.
+	static int64_t getTime();
+
+	// Adds a finished zone to the calling thread's buffer.
+	static void addEvent(const char *name, int64_t startTime, int64_t endTime);
+public:
+	// Returns whether zones are being recorded.
+	static bool isEnabled();
+
+	// Starts or stops recording zones. Recorded zones are kept either way.
+	static void setEnabled(bool enabled);
+
+	// Sets the name of the calling thread in the trace.
+	static void setThreadName(const std::string &name);
+
+	// Writes the zones kept by every thread to a Chrome trace file. Returns whether
+	// the file could be written.
+	static bool writeTrace(const std::string &filename);
+};
+
+// The zone's constructor and destructor are in the header so a disabled zone
+// doesn't cost a function call.
+
+inline Profiler::Zone::Zone(const char *name)
+	: name(name)
+{
+	this->startTime = Profiler::enabled.load(std::memory_order_relaxed) ?
+		Profiler::getTime() : -1;
+}
+
+inline Profiler::Zone::~Zone()
+{
+	if (this->startTime >= 0)
+	{
+		Profiler::addEvent(this->name, this->startTime, Profiler::getTime());
+	}
+}
+
+#endif
@@ -1,3 +1,5 @@
+#include <iomanip>
+
 #include "String.h"
 
 std::vector<std::string> String::split(const std::string &str, char separator)
@@ -129,3 +131,10 @@ std::string String::replace(const std::string &str, const std::string &a,
 
 	return newStr;
 }
+
+std::string String::toFixedString(double val, int precision)
+{
+	std::stringstream sstr;
+	sstr << std::fixed << std::setprecision(precision) << val;
+	return sstr.str();
+}
@@ -42,6 +42,9 @@ public:
 	static std::string replace(const std::string &str, const std::string &a, 
 		const std::string &b);
 
+	// Turns a value into a string with a fixed number of digits after the decimal point.
+	static std::string toFixedString(double val, int precision);
+
 	// Turns an integral value into a hex string.
 	template <typename T>
 	static std::string toHexString(T val)
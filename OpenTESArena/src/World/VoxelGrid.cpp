@@ -1,8 +1,11 @@
 #include <algorithm>
+#include <cassert>
 
 #include "VoxelGrid.h"
 
 const double VoxelGrid::DEFAULT_VOXEL_HEIGHT = 1.0;
+const int VoxelGrid::MAX_EMPTY_DISTANCE = 64;
+const int VoxelGrid::OCCUPANCY_TILE_SHIFT = 3;
 
 VoxelGrid::VoxelGrid(int width, int height, int depth, double voxelHeight)
 {
@@ -10,10 +13,23 @@ VoxelGrid::VoxelGrid(int width, int height, int depth, double voxelHeight)
 	this->voxels = std::vector<char>(voxelCount);
 	std::fill(this->voxels.begin(), this->voxels.end(), 0);
 
+	// All air, so every voxel is as far from a solid voxel as can be stored.
+	this->emptyDistances = std::vector<uint8_t>(voxelCount,
+		static_cast<uint8_t>(VoxelGrid::MAX_EMPTY_DISTANCE));
+
+	// Round up to whole tiles. Bits for voxels past the edge stay clear.
+	const int tileSize = 1 << VoxelGrid::OCCUPANCY_TILE_SHIFT;
+	this->occupancyWidth = (width + tileSize - 1) / tileSize;
+	this->occupancyDepth = (depth + tileSize - 1) / tileSize;
+	this->occupancy = std::vector<uint64_t>(
+		this->occupancyWidth * height * this->occupancyDepth, 0);
+
 	this->width = width;
 	this->height = height;
 	this->depth = depth;
 	this->voxelHeight = voxelHeight;
+	this->derivedDataDirty = false;
+	this->revision = 0;
 }
 
 VoxelGrid::VoxelGrid(int width, int height, int depth)
@@ -44,8 +60,25 @@ double VoxelGrid::getVoxelHeight() const
 	return this->voxelHeight;
 }
 
+int VoxelGrid::getOccupancyWidth() const
+{
+	return this->occupancyWidth;
+}
+
+int VoxelGrid::getOccupancyDepth() const
+{
+	return this->occupancyDepth;
+}
+
+int VoxelGrid::getRevision() const
+{
+	return this->revision;
+}
+
 char *VoxelGrid::getVoxels()
 {
+	this->derivedDataDirty = true;
+	this->revision++;
 	return this->voxels.data();
 }
 
@@ -54,8 +87,84 @@ const char *VoxelGrid::getVoxels() const
 	return this->voxels.data();
 }
 
+const uint8_t *VoxelGrid::getEmptyDistances() const
+{
+	this->updateDerivedData();
+	return this->emptyDistances.data();
+}
+
+const uint64_t *VoxelGrid::getOccupancy() const
+{
+	this->updateDerivedData();
+	return this->occupancy.data();
+}
+
+bool VoxelGrid::isSolid(int x, int y, int z) const
+{
+	if ((x < 0) || (y < 0) || (z < 0) ||
+		(x >= this->width) || (y >= this->height) || (z >= this->depth))
+	{
+		return false;
+	}
+
+	const int shift = VoxelGrid::OCCUPANCY_TILE_SHIFT;
+	const int mask = (1 << shift) - 1;
+	const uint64_t tile = this->getOccupancy()[(x >> shift) + (y * this->occupancyWidth) +
+		((z >> shift) * this->occupancyWidth * this->height)];
+	return ((tile >> ((x & mask) | ((z & mask) << shift))) & 1) != 0;
+}
+
+bool VoxelGrid::hasSolidVoxels(int minX, int minY, int minZ,
+	int maxX, int maxY, int maxZ) const
+{
+	assert((minX >= 0) && (minX <= maxX) && (maxX < this->width));
+	assert((minY >= 0) && (minY <= maxY) && (maxY < this->height));
+	assert((minZ >= 0) && (minZ <= maxZ) && (maxZ < this->depth));
+
+	const uint64_t *occupancy = this->getOccupancy();
+	const int shift = VoxelGrid::OCCUPANCY_TILE_SHIFT;
+	const int tileSize = 1 << shift;
+	for (int y = minY; y <= maxY; ++y)
+	{
+		for (int tileZ = (minZ >> shift); tileZ <= (maxZ >> shift); ++tileZ)
+		{
+			for (int tileX = (minX >> shift); tileX <= (maxX >> shift); ++tileX)
+			{
+				const uint64_t tile = occupancy[tileX + (y * this->occupancyWidth) +
+					(tileZ * this->occupancyWidth * this->height)];
+				if (tile == 0)
+				{
+					continue;
+				}
+
+				// Only check the tile's bits that are inside the box.
+				const int startX = std::max(minX - (tileX * tileSize), 0);
+				const int endX = std::min(maxX - (tileX * tileSize), tileSize - 1);
+				const int startZ = std::max(minZ - (tileZ * tileSize), 0);
+				const int endZ = std::min(maxZ - (tileZ * tileSize), tileSize - 1);
+				const uint64_t rowMask = ((static_cast<uint64_t>(1) << (endX + 1)) - 1) &
+					~((static_cast<uint64_t>(1) << startX) - 1);
+
+				uint64_t mask = 0;
+				for (int z = startZ; z <= endZ; ++z)
+				{
+					mask |= rowMask << (z * tileSize);
+				}
+
+				if ((tile & mask) != 0)
+				{
+					return true;
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
 VoxelData &VoxelGrid::getVoxelData(int id)
 {
+	this->revision++;
 	return this->voxelData.at(id);
 }
 
@@ -67,6 +176,138 @@ const VoxelData &VoxelGrid::getVoxelData(int id) const
 int VoxelGrid::addVoxelData(const VoxelData &voxelData)
 {
 	this->voxelData.push_back(voxelData);
+	this->revision++;
 
 	return static_cast<int>(this->voxelData.size() - 1);
 }
+
+void VoxelGrid::setVoxel(int x, int y, int z, char id)
+{
+	assert(x >= 0 && x < this->width);
+	assert(y >= 0 && y < this->height);
+	assert(z >= 0 && z < this->depth);
+
+	char &voxel = this->voxels[x + (y * this->width) + (z * this->width * this->height)];
+	this->revision++;
+	const bool solidityChanged = (voxel > 0) != (id > 0);
+	voxel = id;
+
+	// Nothing else changes if the voxel is still solid or still air, and a dirty
+	// grid is rebuilt later anyway.
+	if (solidityChanged && !this->derivedDataDirty)
+	{
+		this->updateOccupancy(x, y, z);
+
+		// Only voxels closer than the max distance can see a different nearest solid.
+		const int radius = VoxelGrid::MAX_EMPTY_DISTANCE - 1;
+		this->updateEmptyDistances(y,
+			std::max(x - radius, 0),
+			std::max(z - radius, 0),
+			std::min(x + radius + 1, this->width),
+			std::min(z + radius + 1, this->depth));
+	}
+}
+
+void VoxelGrid::updateDerivedData() const
+{
+	if (!this->derivedDataDirty)
+	{
+		return;
+	}
+
+	for (int y = 0; y < this->height; ++y)
+	{
+		this->updateEmptyDistances(y, 0, 0, this->width, this->depth);
+
+		for (int z = 0; z < this->depth; ++z)
+		{
+			for (int x = 0; x < this->width; ++x)
+			{
+				this->updateOccupancy(x, y, z);
+			}
+		}
+	}
+
+	this->derivedDataDirty = false;
+}
+
+void VoxelGrid::updateEmptyDistances(int y, int minX, int minZ, int maxX, int maxZ) const
+{
+	// Any solid voxel close enough to matter is within the max distance of the
+	// rectangle, so the distance transform only needs to cover that much more.
+	// Voxels outside the grid count as air.
+	const int maxDistance = VoxelGrid::MAX_EMPTY_DISTANCE;
+	const int windowMinX = std::max(minX - maxDistance, 0);
+	const int windowMinZ = std::max(minZ - maxDistance, 0);
+	const int windowMaxX = std::min(maxX + maxDistance, this->width);
+	const int windowMaxZ = std::min(maxZ + maxDistance, this->depth);
+	const int windowWidth = windowMaxX - windowMinX;
+	const int windowDepth = windowMaxZ - windowMinZ;
+
+	std::vector<int> distances(windowWidth * windowDepth);
+	for (int z = 0; z < windowDepth; ++z)
+	{
+		for (int x = 0; x < windowWidth; ++x)
+		{
+			const int index = (x + windowMinX) + (y * this->width) +
+				((z + windowMinZ) * this->width * this->height);
+			distances[x + (z * windowWidth)] = (this->voxels[index] > 0) ? 0 : maxDistance;
+		}
+	}
+
+	// Two-pass chamfer distance transform. With all eight neighbors at a cost of
+	// one, it gives the exact Chebyshev distance.
+	auto relax = [&distances, windowWidth, windowDepth](int &distance, int x, int z)
+	{
+		if ((x >= 0) && (x < windowWidth) && (z >= 0) && (z < windowDepth))
+		{
+			distance = std::min(distance, distances[x + (z * windowWidth)] + 1);
+		}
+	};
+
+	for (int z = 0; z < windowDepth; ++z)
+	{
+		for (int x = 0; x < windowWidth; ++x)
+		{
+			int &distance = distances[x + (z * windowWidth)];
+			relax(distance, x - 1, z);
+			relax(distance, x - 1, z - 1);
+			relax(distance, x, z - 1);
+			relax(distance, x + 1, z - 1);
+		}
+	}
+
+	for (int z = windowDepth - 1; z >= 0; --z)
+	{
+		for (int x = windowWidth - 1; x >= 0; --x)
+		{
+			int &distance = distances[x + (z * windowWidth)];
+			relax(distance, x + 1, z);
+			relax(distance, x + 1, z + 1);
+			relax(distance, x, z + 1);
+			relax(distance, x - 1, z + 1);
+		}
+	}
+
+	// Only the requested rectangle is guaranteed correct.
+	for (int z = minZ; z < maxZ; ++z)
+	{
+		for (int x = minX; x < maxX; ++x)
+		{
+			const int index = x + (y * this->width) + (z * this->width * this->height);
+			this->emptyDistances[index] = static_cast<uint8_t>(
+				distances[(x - windowMinX) + ((z - windowMinZ) * windowWidth)]);
+		}
+	}
+}
+
+void VoxelGrid::updateOccupancy(int x, int y, int z) const
+{
+	const int shift = VoxelGrid::OCCUPANCY_TILE_SHIFT;
+	const int mask = (1 << shift) - 1;
+	uint64_t &tile = this->occupancy[(x >> shift) + (y * this->occupancyWidth) +
+		((z >> shift) * this->occupancyWidth * this->height)];
+	const uint64_t bit = static_cast<uint64_t>(1) << ((x & mask) | ((z & mask) << shift));
+	const bool solid = this->voxels[x + (y * this->width) + (z * this->width * this->height)] > 0;
+	tile = solid ? (tile | bit) : (tile & ~bit);
+}
@@ -1,6 +1,7 @@
 #ifndef VOXEL_GRID_H
 #define VOXEL_GRID_H
 
+#include <cstdint>
 #include <vector>
 
 #include "VoxelData.h"
@@ -8,6 +9,17 @@
 // A voxel grid is a 3D array of voxel IDs with their associated voxel definitions.
 // It also has a "voxel height" value to accommodate some of Arena's "tall" voxels.
 
+// The grid also keeps an "empty distance" for each voxel: the Chebyshev distance
+// (in voxels, along X and Z only) to the nearest solid voxel on the same floor,
+// capped at MAX_EMPTY_DISTANCE. Solid voxels have zero. Ray casters use it to jump
+// over open areas instead of stepping through every air voxel.
+
+// Solid/air occupancy is also kept as a bitmap. Each floor is split into 8x8 tiles
+// of voxels, and each tile is one 64-bit word where bit (x + (z * 8)) is set if
+// that voxel is solid. A row of eight voxels along X is one byte, so the air
+// before the next solid voxel in a row is a count of trailing zeros, and a whole
+// tile of air is a zero word.
+
 class VoxelGrid
 {
 private:
@@ -15,9 +27,33 @@ private:
 
 	std::vector<char> voxels;
 	std::vector<VoxelData> voxelData;
+	mutable std::vector<uint8_t> emptyDistances;
+	mutable std::vector<uint64_t> occupancy;
 	int width, height, depth;
+	int occupancyWidth, occupancyDepth; // Number of tiles along X and Z.
 	double voxelHeight; // No need for voxel width or depth; always 1.
+	mutable bool derivedDataDirty; // True if empty distances and occupancy must be rebuilt.
+	int revision; // Changes whenever voxels or voxel data might have changed.
+
+	// Rebuilds the empty distances and occupancy if the voxels were changed without
+	// tracking.
+	void updateDerivedData() const;
+
+	// Recalculates the empty distances of voxels in the given rectangle on one floor.
+	// The max values are exclusive.
+	void updateEmptyDistances(int y, int minX, int minZ, int maxX, int maxZ) const;
+
+	// Sets or clears a voxel's bit in the occupancy bitmap.
+	void updateOccupancy(int x, int y, int z) const;
 public:
+	// Empty distances are capped at this value, which also bounds how far a voxel
+	// change affects the empty distances around it.
+	static const int MAX_EMPTY_DISTANCE;
+
+	// Occupancy tiles are (1 << OCCUPANCY_TILE_SHIFT) voxels wide and deep, so a
+	// tile fits in 64 bits.
+	static const int OCCUPANCY_TILE_SHIFT;
+
 	VoxelGrid(int width, int height, int depth, double voxelHeight);
 	VoxelGrid(int width, int height, int depth);
 	~VoxelGrid();
@@ -30,10 +66,43 @@ public:
 	// Gets the height (Y size) of each voxel.
 	double getVoxelHeight() const;
 
-	// Gets a pointer to the voxel grid data.
+	// Gets the number of occupancy tiles along X and Z.
+	int getOccupancyWidth() const;
+	int getOccupancyDepth() const;
+
+	// Gets a number that changes whenever the voxels or voxel data might have changed
+	// (i.e., through a non-const getter or setVoxel()), so a renderer can tell when
+	// its last frame is out of date.
+	int getRevision() const;
+
+	// Gets a pointer to the voxel grid data. Writing through the non-const pointer
+	// can't be tracked, so calling it causes a full rebuild of the empty distances
+	// and occupancy. Use setVoxel() for changes during the game.
 	char *getVoxels();
 	const char *getVoxels() const;
 
+	// Gets the empty distance of each voxel, laid out like the voxel IDs. They are
+	// rebuilt here if necessary, so this shouldn't be called by multiple threads
+	// at once after a call to the non-const getVoxels(). The same goes for the
+	// occupancy methods below.
+	const uint8_t *getEmptyDistances() const;
+
+	// Gets the occupancy bitmap. Tile (tileX, tileZ) on floor Y is at index
+	// (tileX + (y * occupancyWidth) + (tileZ * occupancyWidth * height)).
+	const uint64_t *getOccupancy() const;
+
+	// Returns whether the voxel at the given coordinate is solid (not air). Voxels
+	// outside the grid are air.
+	bool isSolid(int x, int y, int z) const;
+
+	// Returns whether any voxel in the given box is solid. The bounds are inclusive
+	// and must be inside the grid.
+	bool hasSolidVoxels(int minX, int minY, int minZ, int maxX, int maxY, int maxZ) const;
+
+	// Sets the voxel ID at the given coordinate and updates nearby empty distances
+	// and the occupancy bitmap.
+	void setVoxel(int x, int y, int z, char id);
+
 	// Gets the voxel data associated with an ID. If the voxel ID of air is 0,
 	// then pass the voxel ID minus 1 instead to get the first one.
 	VoxelData &getVoxelData(int index);
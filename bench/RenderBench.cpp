@@ -0,0 +1,962 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Math/Random.h"
+#include "Math/Vector2.h"
+#include "Math/Vector3.h"
+#include "Media/PPMFile.h"
+#include "Rendering/SoftwareRenderer.h"
+#include "Utilities/CPUFeatures.h"
+#include "World/VoxelData.h"
+#include "World/VoxelGrid.h"
+
+// Headless benchmark for the software renderer. It builds a synthetic city block
+// (streets between buildings, with sprites scattered along the streets), walks the
+// camera around it on a fixed path, and reports frame times for each combination
+// of resolution and render thread count. No window or GPU is needed.
+
+// Usage: tesarena_renderbench [--cpu=<tier>] [--3d | --3d-tiled | --paletted] [frames]
+//                             [resolutions] [thread counts]
+// - "--cpu" forces a SIMD tier (Scalar, SSE2, or AVX2) instead of the best one the
+//   CPU supports. It also works before the golden image and precision arguments.
+// - Resolutions and thread counts are comma-separated, i.e., "640x400,1920x1080"
+//   and "1,4,0". A thread count of zero means one per hardware thread.
+// - "--3d" ray casts every pixel in 3D instead of every column in 2.5D, and
+//   "--3d-tiled" does it in square tiles of pixels instead of columns.
+// - "--paletted" draws 2.5D frames as palette indices (see makePalette()).
+
+// Golden image mode: tesarena_renderbench --golden-write <dir>
+//                    tesarena_renderbench --golden-check <dir> [tolerance]
+// - Renders a fixed set of camera poses. "Write" saves the frames and their render
+//   times as the reference. "Check" compares new frames against them, failing if
+//   any color channel differs by more than the tolerance (default 0), and prints
+//   the render time of each pose next to the reference time.
+
+// Precision mode: tesarena_renderbench --precision-check [tolerance]
+// - Renders the golden image poses with the city at the world origin and again at
+//   the far corner of a grid as big as Arena's wilderness, failing if the frames
+//   differ by more than the tolerance (default 0). This is the error bound for the
+//   renderer's precision (see SoftwareRenderer::Real).
+
+// Frame reuse mode: tesarena_renderbench --reuse-check
+// - Moves the camera and flats over a sequence of frames, some of which change
+//   nothing, and fails if a frame from render() or startRender()/finishRender()
+//   (which reuse or partly redraw the last frame) differs at all from the same
+//   frame drawn in full. Runs in 2.5D, paletted 2.5D (with output palette changes),
+//   and 3D.
+
+// Voxel edit mode: tesarena_renderbench --voxel-edit-check
+// - Makes random VoxelGrid::setVoxel() edits to the city and fails if the empty
+//   distances or occupancy bitmap it updates ever differ from a full rebuild.
+
+namespace
+{
+	const int DEFAULT_FRAME_COUNT = 300;
+	const std::string DEFAULT_RESOLUTIONS = "640x400,1280x800,1920x1080";
+	const std::string DEFAULT_THREAD_COUNTS = "1,0";
+
+	// Frames rendered before timing starts (the first frames allocate memory).
+	const int WARMUP_FRAME_COUNT = 5;
+
+	// The scene is a grid of square buildings with two-voxel-wide streets between.
+	const int GRID_WIDTH = 64;
+	const int GRID_HEIGHT = 5;
+	const int GRID_DEPTH = 64;
+	const int BLOCK_SIZE = 8;
+	const int FLAT_COUNT = 1000;
+	const int TEXTURE_COUNT = 4;
+	const int TEXTURE_SIZE = 64;
+
+	// Palette colors for each texture: a brightness ramp of its tint, then a ramp from
+	// its tint to the fog color. There are 256 in all.
+	const int PALETTE_SHADE_COUNT = 40;
+	const int PALETTE_FOG_COUNT = 24;
+
+	// The renderer's default fog color, for the palette.
+	const int FOG_R = 102;
+	const int FOG_G = 165;
+	const int FOG_B = 255;
+
+	// Field of view and view distance similar to the game's defaults.
+	const double FOV_Y = 60.0;
+	const double VIEW_DISTANCE = 25.0;
+
+	// Eye height above the ground (the bottom of voxel layer 1).
+	const double EYE_HEIGHT = 1.50;
+
+	// Golden images are at Arena's original resolution to keep them small.
+	const int GOLDEN_WIDTH = 320;
+	const int GOLDEN_HEIGHT = 200;
+	const int GOLDEN_POSE_COUNT = 8;
+	const int GOLDEN_TIMING_FRAME_COUNT = 25; // Renders per pose for its median time.
+	const std::string GOLDEN_TIMINGS_FILENAME = "timings.txt";
+
+	// The largest world Arena has is the wilderness, at 64x64 chunks of 64x64 voxels.
+	const int FAR_GRID_SIZE = 4096;
+	const int FAR_OFFSET = FAR_GRID_SIZE - GRID_WIDTH;
+
+	// Frame reuse check: frames per mode, and how many flats each flat edit touches.
+	const int REUSE_STEP_COUNT = 64;
+	const int REUSE_FLAT_EDIT_COUNT = 40;
+
+	// Voxel edit check: random edits made to the city, each checked against a rebuild.
+	const int VOXEL_EDIT_COUNT = 1000;
+
+	// Returns whether the given column is a street instead of a building.
+	bool isStreet(int x, int z)
+	{
+		return ((x % BLOCK_SIZE) < 2) || ((z % BLOCK_SIZE) < 2);
+	}
+
+	// Splits a comma-separated list.
+	std::vector<std::string> split(const std::string &str)
+	{
+		std::vector<std::string> tokens;
+		std::stringstream ss(str);
+		std::string token;
+		while (std::getline(ss, token, ','))
+		{
+			if (token.size() > 0)
+			{
+				tokens.push_back(token);
+			}
+		}
+
+		return tokens;
+	}
+
+	// Fills the city into the grid, starting at the given offset on the X and Z axes.
+	void fillVoxelGrid(VoxelGrid &voxelGrid, Random &random, int offset)
+	{
+		// Each voxel data refers to the texture with the same index.
+		for (int i = 0; i < TEXTURE_COUNT; ++i)
+		{
+			voxelGrid.addVoxelData(VoxelData(i, i));
+		}
+
+		char *voxels = voxelGrid.getVoxels();
+		for (int z = 0; z < GRID_DEPTH; ++z)
+		{
+			for (int x = 0; x < GRID_WIDTH; ++x)
+			{
+				const bool isEdge = (x == 0) || (z == 0) ||
+					(x == (GRID_WIDTH - 1)) || (z == (GRID_DEPTH - 1));
+				const int buildingHeight = (isEdge || !isStreet(x, z)) ?
+					(1 + random.next(GRID_HEIGHT - 1)) : 0;
+
+				// Ground layer, then the building on top of it.
+				for (int y = 0; y <= buildingHeight; ++y)
+				{
+					const int index = (x + offset) + (y * voxelGrid.getWidth()) +
+						((z + offset) * voxelGrid.getWidth() * voxelGrid.getHeight());
+					voxels[index] = static_cast<char>(1 + random.next(TEXTURE_COUNT));
+				}
+			}
+		}
+	}
+
+	void addTextures(SoftwareRenderer &renderer)
+	{
+		for (int i = 0; i < TEXTURE_COUNT; ++i)
+		{
+			std::vector<uint32_t> texels(TEXTURE_SIZE * TEXTURE_SIZE);
+			for (int y = 0; y < TEXTURE_SIZE; ++y)
+			{
+				for (int x = 0; x < TEXTURE_SIZE; ++x)
+				{
+					// Brick-like pattern, tinted differently per texture.
+					const bool mortar = ((y % 8) == 0) || (((x + ((y / 8) * 4)) % 16) == 0);
+					const uint32_t shade = mortar ? 0x40 : (0x80 + ((x * 7 + y * 13) & 0x3F));
+					const uint32_t r = (shade * (2 + (i % 3))) / 4;
+					const uint32_t g = (shade * (2 + ((i + 1) % 3))) / 4;
+					const uint32_t b = (shade * (2 + ((i + 2) % 3))) / 4;
+					texels[x + (y * TEXTURE_SIZE)] = 0xFF000000 | (r << 16) | (g << 8) | b;
+				}
+			}
+
+			renderer.addTexture(texels.data(), TEXTURE_SIZE, TEXTURE_SIZE, true);
+		}
+	}
+
+	// Makes a palette for indexed rendering that's close to the textures' colors,
+	// like Arena's palettes have ramps for each material.
+	std::vector<uint32_t> makePalette()
+	{
+		auto makeColor = [](int r, int g, int b)
+		{
+			return 0xFF000000 | (static_cast<uint32_t>(r) << 16) |
+				(static_cast<uint32_t>(g) << 8) | static_cast<uint32_t>(b);
+		};
+
+		std::vector<uint32_t> palette;
+		for (int i = 0; i < TEXTURE_COUNT; ++i)
+		{
+			// Same tint as in addTextures().
+			const int tintR = 2 + (i % 3);
+			const int tintG = 2 + ((i + 1) % 3);
+			const int tintB = 2 + ((i + 2) % 3);
+			for (int j = 0; j < PALETTE_SHADE_COUNT; ++j)
+			{
+				const int shade = (j * 255) / (PALETTE_SHADE_COUNT - 1);
+				palette.push_back(makeColor((shade * tintR) / 4, (shade * tintG) / 4,
+					(shade * tintB) / 4));
+			}
+
+			// Starts from a typical brick shade.
+			const int baseR = (0xA0 * tintR) / 4;
+			const int baseG = (0xA0 * tintG) / 4;
+			const int baseB = (0xA0 * tintB) / 4;
+			for (int j = 1; j <= PALETTE_FOG_COUNT; ++j)
+			{
+				palette.push_back(makeColor(
+					baseR + (((FOG_R - baseR) * j) / PALETTE_FOG_COUNT),
+					baseG + (((FOG_G - baseG) * j) / PALETTE_FOG_COUNT),
+					baseB + (((FOG_B - baseB) * j) / PALETTE_FOG_COUNT)));
+			}
+		}
+
+		return palette;
+	}
+
+	// Gets a random point on a street for a flat to stand on.
+	Double3 getRandomFlatPosition(Random &random, int offset)
+	{
+		while (true)
+		{
+			const int x = 1 + random.next(GRID_WIDTH - 2);
+			const int z = 1 + random.next(GRID_DEPTH - 2);
+			if (isStreet(x, z))
+			{
+				return Double3(
+					static_cast<double>(x + offset) + random.nextReal(),
+					1.0,
+					static_cast<double>(z + offset) + random.nextReal());
+			}
+		}
+	}
+
+	// Returns the IDs of the added flats.
+	std::vector<int> addFlats(SoftwareRenderer &renderer, Random &random, int offset)
+	{
+		std::vector<int> flatIDs;
+		for (int added = 0; added < FLAT_COUNT; ++added)
+		{
+			const Double3 position = getRandomFlatPosition(random, offset);
+			const Double2 direction = ((added % 2) == 0) ?
+				Double2(1.0, 0.0) : Double2(0.0, 1.0);
+			flatIDs.push_back(renderer.addFlat(position, direction,
+				0.50 + (random.nextReal() * 0.50), 0.50 + (random.nextReal() * 0.50),
+				random.next(TEXTURE_COUNT)));
+		}
+
+		return flatIDs;
+	}
+
+	// The renderer's constructor adds a grid of test flats near the world origin. This
+	// adds the same flats at an offset, so a city moved by that offset looks the same.
+	// Returns the IDs of the added flats.
+	std::vector<int> addTestFlatCopies(SoftwareRenderer &renderer, int offset)
+	{
+		std::vector<int> flatIDs;
+		for (int k = 4; k < 16; ++k)
+		{
+			for (int i = 4; i < 16; ++i)
+			{
+				flatIDs.push_back(renderer.addFlat(Double3(static_cast<double>(i + offset),
+					1.0, static_cast<double>(k + offset)), Double2(-1.0, 0.0), 0.8, 0.9, i % 3));
+			}
+		}
+
+		return flatIDs;
+	}
+
+	// Sets the camera for a point along the path, where the percent is in [0, 1).
+	// The camera walks a square loop of streets while looking around a bit. The offset
+	// is where the city starts on the X and Z axes.
+	void setCamera(SoftwareRenderer &renderer, double percent, int offset)
+	{
+		const Double2 corners[] =
+		{
+			Double2(9.0, 9.0),
+			Double2(57.0, 9.0),
+			Double2(57.0, 57.0),
+			Double2(9.0, 57.0)
+		};
+
+		const double legReal = percent * 4.0;
+		const int leg = std::min(static_cast<int>(legReal), 3);
+		const double legPercent = legReal - static_cast<double>(leg);
+		const Double2 &start = corners[leg];
+		const Double2 &end = corners[(leg + 1) % 4];
+		const Double2 position = start + ((end - start) * legPercent);
+
+		const double twoPi = 6.283185307179586;
+		const double yaw = std::atan2(end.y - start.y, end.x - start.x) +
+			(0.60 * std::sin(percent * twoPi * 6.0));
+		const double pitch = 0.15 * std::sin(percent * twoPi * 3.0);
+
+		renderer.setEye(Double3(position.x + static_cast<double>(offset), EYE_HEIGHT,
+			position.y + static_cast<double>(offset)));
+		renderer.setForward(Double3(std::cos(yaw), pitch, std::sin(yaw)));
+	}
+
+	// Makes a renderer with the benchmark's textures and flats, for a city at the
+	// given offset. The IDs of the benchmark's flats are written to the given vector
+	// if it isn't null.
+	std::unique_ptr<SoftwareRenderer> makeRenderer(int width, int height, int threadCount,
+		int offset, std::vector<int> *flatIDs)
+	{
+		std::unique_ptr<SoftwareRenderer> renderer(
+			new SoftwareRenderer(width, height, threadCount, false));
+		renderer->setFovY(FOV_Y);
+		renderer->setViewDistance(VIEW_DISTANCE);
+		addTextures(*renderer.get());
+
+		Random random(1);
+		std::vector<int> addedFlatIDs = addFlats(*renderer.get(), random, offset);
+		if (flatIDs != nullptr)
+		{
+			*flatIDs = addedFlatIDs;
+		}
+
+		return renderer;
+	}
+
+	// Gets the camera path percent of a golden image pose.
+	double getGoldenPosePercent(int pose)
+	{
+		// Offset a little so the poses aren't exactly at street corners.
+		return (static_cast<double>(pose) + 0.10) / static_cast<double>(GOLDEN_POSE_COUNT);
+	}
+
+	std::string getGoldenFilename(const std::string &directory, int pose)
+	{
+		return directory + "/pose" + std::to_string(pose) + ".ppm";
+	}
+
+	// Renders a golden image pose several times and returns the median time in
+	// milliseconds. The renderer's pixels are left with the pose's image.
+	double renderGoldenPose(SoftwareRenderer &renderer, const VoxelGrid &voxelGrid, int pose,
+		int offset)
+	{
+		setCamera(renderer, getGoldenPosePercent(pose), offset);
+
+		// The internal frame buffer would just keep the last frame for an unchanged
+		// camera, so the timed frames are drawn in full to another buffer.
+		std::vector<uint32_t> framePixels(GOLDEN_WIDTH * GOLDEN_HEIGHT);
+		std::vector<double> frameTimes;
+		for (int i = 0; i < GOLDEN_TIMING_FRAME_COUNT; ++i)
+		{
+			const auto startTime = std::chrono::steady_clock::now();
+			renderer.render(voxelGrid, framePixels.data(),
+				GOLDEN_WIDTH * static_cast<int>(sizeof(uint32_t)));
+			const std::chrono::duration<double, std::milli> frameTime =
+				std::chrono::steady_clock::now() - startTime;
+			frameTimes.push_back(frameTime.count());
+		}
+
+		renderer.render(voxelGrid);
+
+		std::sort(frameTimes.begin(), frameTimes.end());
+		return frameTimes[frameTimes.size() / 2];
+	}
+
+	// Returns how many pixels have a color channel that differs by more than the
+	// tolerance (the alpha byte isn't compared, since PPM files don't store it).
+	int comparePixels(const uint32_t *pixels, const uint32_t *reference, int count,
+		int tolerance, int &maxDifference)
+	{
+		int badPixelCount = 0;
+		maxDifference = 0;
+		for (int i = 0; i < count; ++i)
+		{
+			int pixelDifference = 0;
+			for (int shift = 0; shift <= 16; shift += 8)
+			{
+				const int a = static_cast<int>((pixels[i] >> shift) & 0xFF);
+				const int b = static_cast<int>((reference[i] >> shift) & 0xFF);
+				pixelDifference = std::max(pixelDifference, std::abs(a - b));
+			}
+
+			maxDifference = std::max(maxDifference, pixelDifference);
+			badPixelCount += (pixelDifference > tolerance) ? 1 : 0;
+		}
+
+		return badPixelCount;
+	}
+
+	int writeGoldenImages(const VoxelGrid &voxelGrid, const std::string &directory)
+	{
+		std::unique_ptr<SoftwareRenderer> renderer = makeRenderer(
+			GOLDEN_WIDTH, GOLDEN_HEIGHT, 0, 0, nullptr);
+		std::ofstream timings(directory + "/" + GOLDEN_TIMINGS_FILENAME);
+		if (!timings.is_open())
+		{
+			std::fprintf(stderr, "Couldn't write to \"%s\".\n", directory.c_str());
+			return EXIT_FAILURE;
+		}
+
+		for (int pose = 0; pose < GOLDEN_POSE_COUNT; ++pose)
+		{
+			const double medianMs = renderGoldenPose(*renderer.get(), voxelGrid, pose, 0);
+			const std::string filename = getGoldenFilename(directory, pose);
+			PPMFile::write(renderer->getPixels(), GOLDEN_WIDTH, GOLDEN_HEIGHT,
+				"tesarena_renderbench pose " + std::to_string(pose), filename);
+			timings << pose << " " << medianMs << "\n";
+
+			std::printf("Wrote %s (%.3f ms).\n", filename.c_str(), medianMs);
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	int checkGoldenImages(const VoxelGrid &voxelGrid, const std::string &directory,
+		int tolerance)
+	{
+		// Reference times are optional; they're only for comparison.
+		std::vector<double> referenceTimes(GOLDEN_POSE_COUNT, 0.0);
+		std::ifstream timings(directory + "/" + GOLDEN_TIMINGS_FILENAME);
+		int timingPose;
+		double timingMs;
+		while (timings >> timingPose >> timingMs)
+		{
+			if ((timingPose >= 0) && (timingPose < GOLDEN_POSE_COUNT))
+			{
+				referenceTimes[timingPose] = timingMs;
+			}
+		}
+
+		std::unique_ptr<SoftwareRenderer> renderer = makeRenderer(
+			GOLDEN_WIDTH, GOLDEN_HEIGHT, 0, 0, nullptr);
+
+		std::printf("%-6s %10s %10s %8s %12s %10s %8s\n", "Pose", "Bad pixels",
+			"Max diff", "Result", "Ref (ms)", "New (ms)", "Change");
+
+		bool allPassed = true;
+		double referenceTotal = 0.0;
+		double newTotal = 0.0;
+		for (int pose = 0; pose < GOLDEN_POSE_COUNT; ++pose)
+		{
+			const double medianMs = renderGoldenPose(*renderer.get(), voxelGrid, pose, 0);
+
+			int width, height;
+			const std::unique_ptr<uint32_t[]> reference = PPMFile::read(
+				getGoldenFilename(directory, pose), width, height);
+			if ((width != GOLDEN_WIDTH) || (height != GOLDEN_HEIGHT))
+			{
+				std::fprintf(stderr, "Golden image %d has the wrong dimensions.\n", pose);
+				return EXIT_FAILURE;
+			}
+
+			int maxDifference;
+			const int badPixelCount = comparePixels(renderer->getPixels(),
+				reference.get(), width * height, tolerance, maxDifference);
+
+			const bool passed = badPixelCount == 0;
+			allPassed &= passed;
+
+			// Negative change means faster than the reference.
+			const double referenceMs = referenceTimes[pose];
+			const double change = (referenceMs > 0.0) ?
+				(100.0 * (medianMs - referenceMs) / referenceMs) : 0.0;
+			referenceTotal += referenceMs;
+			newTotal += medianMs;
+
+			std::printf("%-6d %10d %10d %8s %12.3f %10.3f %+7.1f%%\n", pose, badPixelCount,
+				maxDifference, passed ? "pass" : "FAIL", referenceMs, medianMs, change);
+		}
+
+		const double totalChange = (referenceTotal > 0.0) ?
+			(100.0 * (newTotal - referenceTotal) / referenceTotal) : 0.0;
+		std::printf("%s (tolerance %d), total time %+.1f%%.\n",
+			allPassed ? "Pixels unchanged" : "Pixels changed", tolerance, totalChange);
+
+		return allPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	// Renders the golden image poses near the world origin and far from it, and
+	// compares the two.
+	int checkPrecision(const VoxelGrid &voxelGrid, int tolerance)
+	{
+		std::printf("%s precision, city offset by %d voxels in a %dx%d grid.\n",
+			SoftwareRenderer::getPrecisionName(), FAR_OFFSET, FAR_GRID_SIZE, FAR_GRID_SIZE);
+
+		Random random(0);
+		VoxelGrid farVoxelGrid(FAR_GRID_SIZE, GRID_HEIGHT, FAR_GRID_SIZE, 1.0);
+		fillVoxelGrid(farVoxelGrid, random, FAR_OFFSET);
+
+		std::unique_ptr<SoftwareRenderer> renderer = makeRenderer(
+			GOLDEN_WIDTH, GOLDEN_HEIGHT, 0, 0, nullptr);
+		std::unique_ptr<SoftwareRenderer> farRenderer = makeRenderer(
+			GOLDEN_WIDTH, GOLDEN_HEIGHT, 0, FAR_OFFSET, nullptr);
+		addTestFlatCopies(*farRenderer.get(), FAR_OFFSET);
+
+		std::printf("%-6s %-6s %10s %10s %8s\n", "Mode", "Pose", "Bad pixels", "Max diff",
+			"Result");
+
+		// 2.5D and 3D ray casting each have their own math.
+		bool allPassed = true;
+		for (const bool full3D : { false, true })
+		{
+			renderer->setFull3D(full3D);
+			farRenderer->setFull3D(full3D);
+
+			for (int pose = 0; pose < GOLDEN_POSE_COUNT; ++pose)
+			{
+				renderGoldenPose(*renderer.get(), voxelGrid, pose, 0);
+				renderGoldenPose(*farRenderer.get(), farVoxelGrid, pose, FAR_OFFSET);
+
+				int maxDifference;
+				const int badPixelCount = comparePixels(farRenderer->getPixels(),
+					renderer->getPixels(), GOLDEN_WIDTH * GOLDEN_HEIGHT, tolerance,
+					maxDifference);
+
+				const bool passed = badPixelCount == 0;
+				allPassed &= passed;
+
+				std::printf("%-6s %-6d %10d %10d %8s\n", full3D ? "3D" : "2.5D", pose,
+					badPixelCount, maxDifference, passed ? "pass" : "FAIL");
+			}
+		}
+
+		std::printf("%s (tolerance %d).\n", allPassed ?
+			"Far frames match" : "Far frames differ", tolerance);
+
+		return allPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	// Edits the scene the same way in each renderer for one step of the frame reuse
+	// check. The steps cycle through moving the camera, changing nothing, moving
+	// flats, and replacing flats, so every kind of frame change is drawn. Each renderer
+	// has its own list of flat IDs, and replaced flats get their new IDs.
+	void editReuseScene(SoftwareRenderer *const *renderers, std::vector<int> *flatIDs,
+		int rendererCount, int step, Random &random)
+	{
+		const int edit = step % 4;
+		if (edit == 0)
+		{
+			const double percent = static_cast<double>(step) /
+				static_cast<double>(REUSE_STEP_COUNT);
+			for (int i = 0; i < rendererCount; ++i)
+			{
+				setCamera(*renderers[i], percent, 0);
+			}
+		}
+		else if (edit == 2)
+		{
+			for (int j = 0; j < REUSE_FLAT_EDIT_COUNT; ++j)
+			{
+				const int index = random.next(static_cast<int>(flatIDs[0].size()));
+				const Double3 position = getRandomFlatPosition(random, 0);
+				const int textureID = random.next(TEXTURE_COUNT);
+				for (int i = 0; i < rendererCount; ++i)
+				{
+					renderers[i]->updateFlat(flatIDs[i][index], &position, nullptr, nullptr,
+						nullptr, &textureID);
+				}
+			}
+		}
+		else if (edit == 3)
+		{
+			for (int j = 0; j < REUSE_FLAT_EDIT_COUNT; ++j)
+			{
+				const int index = random.next(static_cast<int>(flatIDs[0].size()));
+				const Double3 position = getRandomFlatPosition(random, 0);
+				const double width = 0.50 + (random.nextReal() * 0.50);
+				const double height = 0.50 + (random.nextReal() * 0.50);
+				const int textureID = random.next(TEXTURE_COUNT);
+				for (int i = 0; i < rendererCount; ++i)
+				{
+					renderers[i]->removeFlat(flatIDs[i][index]);
+					flatIDs[i][index] = renderers[i]->addFlat(position, Double2(1.0, 0.0),
+						width, height, textureID);
+				}
+			}
+		}
+	}
+
+	// Draws a sequence of frames with the internal frame buffer and with pipelining,
+	// which only redraw what changed, and compares them with full frames drawn to
+	// another buffer.
+	int checkFrameReuse(const VoxelGrid &voxelGrid)
+	{
+		std::printf("%-14s %8s %8s %8s %8s %10s %8s\n", "Mode", "Frames", "Reused", "Palette",
+			"Partial", "Bad frames", "Result");
+
+		// Frames also switch to a darker output palette and back, like a palette effect
+		// would, once on a step that changes nothing else and once while replacing
+		// flats. That's only drawn by paletted frames, and does nothing to the others.
+		const std::vector<uint32_t> palette = makePalette();
+		std::vector<uint32_t> darkPalette(palette.size());
+		for (size_t i = 0; i < palette.size(); ++i)
+		{
+			darkPalette[i] = (palette[i] >> 1) & 0x7F7F7F7F;
+		}
+
+		const char *modeNames[] = { "2.5D", "Paletted 2.5D", "3D" };
+
+		bool allPassed = true;
+		for (int mode = 0; mode < 3; ++mode)
+		{
+			// The first renderer is the reference, drawing every frame in full.
+			std::unique_ptr<SoftwareRenderer> rendererPtrs[3];
+			SoftwareRenderer *renderers[3];
+			std::vector<int> flatIDs[3];
+			for (int i = 0; i < 3; ++i)
+			{
+				rendererPtrs[i] = makeRenderer(GOLDEN_WIDTH, GOLDEN_HEIGHT, 0, 0, &flatIDs[i]);
+				renderers[i] = rendererPtrs[i].get();
+				renderers[i]->setFull3D(mode == 2);
+
+				if (mode == 1)
+				{
+					renderers[i]->setPalette(palette.data());
+					renderers[i]->setIndexedRendering(true);
+				}
+			}
+
+			SoftwareRenderer &referenceRenderer = *renderers[0];
+			SoftwareRenderer &reuseRenderer = *renderers[1];
+			SoftwareRenderer &pipelinedRenderer = *renderers[2];
+
+			Random random(2);
+			std::vector<uint32_t> referencePixels(GOLDEN_WIDTH * GOLDEN_HEIGHT);
+			int reusedCount = 0;
+			int paletteCount = 0;
+			int partialCount = 0;
+			int badFrameCount = 0;
+			for (int step = 0; step < REUSE_STEP_COUNT; ++step)
+			{
+				editReuseScene(renderers, flatIDs, 3, step, random);
+
+				const bool paletteOnlyStep = (step % 16) == 5;
+				if (paletteOnlyStep || ((step % 16) == 11))
+				{
+					const bool dark = ((step / 8) % 2) == 0;
+					for (int i = 0; i < 3; ++i)
+					{
+						renderers[i]->setOutputPalette(dark ?
+							darkPalette.data() : palette.data());
+					}
+				}
+
+				// Only the first frame has nothing to reuse.
+				bool badFrameChange = false;
+				if (step > 0)
+				{
+					const SoftwareRenderer::FrameChange frameChange =
+						reuseRenderer.getFrameChange(voxelGrid);
+					reusedCount += (frameChange == SoftwareRenderer::FrameChange::None) ? 1 : 0;
+					paletteCount += (frameChange == SoftwareRenderer::FrameChange::Palette) ? 1 : 0;
+					partialCount += (frameChange == SoftwareRenderer::FrameChange::Columns) ? 1 : 0;
+
+					// An output palette change alone only converts the indices again.
+					if (paletteOnlyStep)
+					{
+						const SoftwareRenderer::FrameChange expectedChange = (mode == 1) ?
+							SoftwareRenderer::FrameChange::Palette :
+							SoftwareRenderer::FrameChange::None;
+						badFrameChange = frameChange != expectedChange;
+					}
+				}
+
+				referenceRenderer.render(voxelGrid, referencePixels.data(),
+					GOLDEN_WIDTH * static_cast<int>(sizeof(uint32_t)));
+				reuseRenderer.render(voxelGrid);
+				pipelinedRenderer.startRender(voxelGrid);
+				pipelinedRenderer.finishRender();
+
+				int maxDifference;
+				const int reuseBadPixelCount = comparePixels(reuseRenderer.getPixels(),
+					referencePixels.data(), GOLDEN_WIDTH * GOLDEN_HEIGHT, 0, maxDifference);
+				const int pipelinedBadPixelCount = comparePixels(pipelinedRenderer.getPixels(),
+					referencePixels.data(), GOLDEN_WIDTH * GOLDEN_HEIGHT, 0, maxDifference);
+				if (badFrameChange)
+				{
+					std::fprintf(stderr, "%s frame %d drew more than the output palette change.\n",
+						modeNames[mode], step);
+					badFrameCount++;
+				}
+				else if ((reuseBadPixelCount > 0) || (pipelinedBadPixelCount > 0))
+				{
+					std::fprintf(stderr, "%s frame %d differs (%d reused, %d pipelined pixels).\n",
+						modeNames[mode], step, reuseBadPixelCount, pipelinedBadPixelCount);
+					badFrameCount++;
+				}
+			}
+
+			const bool passed = badFrameCount == 0;
+			allPassed &= passed;
+
+			std::printf("%-14s %8d %8d %8d %8d %10d %8s\n", modeNames[mode], REUSE_STEP_COUNT,
+				reusedCount, paletteCount, partialCount, badFrameCount, passed ? "pass" : "FAIL");
+		}
+
+		std::printf("%s.\n", allPassed ? "Reused frames match" : "Reused frames differ");
+
+		return allPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	// Makes random edits to a grid with VoxelGrid::setVoxel(), and after each one,
+	// compares the empty distances and occupancy it updated with ones rebuilt from
+	// scratch for the same voxels. Returns the number of edits that differed.
+	int checkVoxelGridEdits(VoxelGrid &voxelGrid, Random &random)
+	{
+		// Edits only update the derived data incrementally once it has been built.
+		voxelGrid.getEmptyDistances();
+
+		const int voxelCount = GRID_WIDTH * GRID_HEIGHT * GRID_DEPTH;
+		const int occupancyCount = voxelGrid.getOccupancyWidth() * GRID_HEIGHT *
+			voxelGrid.getOccupancyDepth();
+
+		int badEditCount = 0;
+		for (int i = 0; i < VOXEL_EDIT_COUNT; ++i)
+		{
+			// About half of the edits clear a voxel.
+			const int x = random.next(GRID_WIDTH);
+			const int y = random.next(GRID_HEIGHT);
+			const int z = random.next(GRID_DEPTH);
+			const char id = static_cast<char>((random.next(2) == 0) ?
+				0 : (1 + random.next(TEXTURE_COUNT)));
+			voxelGrid.setVoxel(x, y, z, id);
+
+			// Writing through the non-const pointer makes the grid rebuild everything.
+			VoxelGrid rebuiltGrid(GRID_WIDTH, GRID_HEIGHT, GRID_DEPTH, 1.0);
+			const char *voxels = static_cast<const VoxelGrid&>(voxelGrid).getVoxels();
+			std::copy(voxels, voxels + voxelCount, rebuiltGrid.getVoxels());
+
+			const bool distancesMatch = std::equal(voxelGrid.getEmptyDistances(),
+				voxelGrid.getEmptyDistances() + voxelCount, rebuiltGrid.getEmptyDistances());
+			const bool occupancyMatches = std::equal(voxelGrid.getOccupancy(),
+				voxelGrid.getOccupancy() + occupancyCount, rebuiltGrid.getOccupancy());
+			if (!distancesMatch || !occupancyMatches)
+			{
+				std::fprintf(stderr, "Edit %d (%d, %d, %d) = %d: %s differ.\n", i, x, y, z,
+					static_cast<int>(id), distancesMatch ? "occupancy bits" :
+					(occupancyMatches ? "empty distances" : "empty distances and occupancy bits"));
+				badEditCount++;
+			}
+		}
+
+		return badEditCount;
+	}
+
+	// Checks voxel edits in the city and in an empty grid, where empty distances are
+	// long enough to reach the edge of what an edit updates.
+	int checkVoxelEdits()
+	{
+		std::printf("%-6s %8s %10s %8s\n", "Grid", "Edits", "Bad edits", "Result");
+
+		bool allPassed = true;
+		for (const bool empty : { false, true })
+		{
+			Random random(0);
+			VoxelGrid voxelGrid(GRID_WIDTH, GRID_HEIGHT, GRID_DEPTH, 1.0);
+			if (!empty)
+			{
+				fillVoxelGrid(voxelGrid, random, 0);
+			}
+
+			const int badEditCount = checkVoxelGridEdits(voxelGrid, random);
+			const bool passed = badEditCount == 0;
+			allPassed &= passed;
+
+			std::printf("%-6s %8d %10d %8s\n", empty ? "Empty" : "City", VOXEL_EDIT_COUNT,
+				badEditCount, passed ? "pass" : "FAIL");
+		}
+
+		std::printf("%s.\n", allPassed ?
+			"Incremental updates match rebuilds" : "Incremental updates differ");
+
+		return allPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	struct Result
+	{
+		double minMs, medianMs, p99Ms;
+		double busyPercent; // Average render thread utilization.
+	};
+
+	Result runBenchmark(const VoxelGrid &voxelGrid, int width, int height,
+		int threadCount, int frameCount, bool full3D, bool tiled3D, bool paletted)
+	{
+		std::unique_ptr<SoftwareRenderer> rendererPtr = makeRenderer(
+			width, height, threadCount, 0, nullptr);
+		SoftwareRenderer &renderer = *rendererPtr.get();
+		renderer.setFull3D(full3D);
+		renderer.setTiled3D(tiled3D);
+
+		if (paletted)
+		{
+			const std::vector<uint32_t> palette = makePalette();
+			renderer.setPalette(palette.data());
+			renderer.setIndexedRendering(true);
+		}
+
+		// Warm up with full frames, since an unchanged camera would reuse the last one.
+		std::vector<uint32_t> warmupPixels(width * height);
+		setCamera(renderer, 0.0, 0);
+		for (int i = 0; i < WARMUP_FRAME_COUNT; ++i)
+		{
+			renderer.render(voxelGrid, warmupPixels.data(),
+				width * static_cast<int>(sizeof(uint32_t)));
+		}
+
+		std::vector<double> frameTimes;
+		double busySeconds = 0.0;
+		double idleSeconds = 0.0;
+		for (int i = 0; i < frameCount; ++i)
+		{
+			setCamera(renderer, static_cast<double>(i) / static_cast<double>(frameCount), 0);
+
+			const auto startTime = std::chrono::steady_clock::now();
+			renderer.render(voxelGrid);
+			const std::chrono::duration<double, std::milli> frameTime =
+				std::chrono::steady_clock::now() - startTime;
+			frameTimes.push_back(frameTime.count());
+
+			for (const auto &timing : renderer.getThreadTimings())
+			{
+				busySeconds += timing.busySeconds;
+				idleSeconds += timing.idleSeconds;
+			}
+		}
+
+		std::sort(frameTimes.begin(), frameTimes.end());
+		const int p99Index = std::max(static_cast<int>(std::ceil(
+			0.99 * static_cast<double>(frameTimes.size()))) - 1, 0);
+
+		Result result;
+		result.minMs = frameTimes.front();
+		result.medianMs = frameTimes[frameTimes.size() / 2];
+		result.p99Ms = frameTimes[p99Index];
+		result.busyPercent = ((busySeconds + idleSeconds) > 0.0) ?
+			(100.0 * busySeconds / (busySeconds + idleSeconds)) : 0.0;
+		return result;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	// The SIMD tier comes before any other arguments.
+	const std::string cpuPrefix = "--cpu=";
+	if ((argc > 1) && (std::string(argv[1]).compare(0, cpuPrefix.size(), cpuPrefix) == 0))
+	{
+		const std::string tierName = std::string(argv[1]).substr(cpuPrefix.size());
+		CPUFeatures::Tier tier;
+		if (!CPUFeatures::tryParseTier(tierName, tier))
+		{
+			std::fprintf(stderr, "Invalid CPU feature tier \"%s\".\n", tierName.c_str());
+			return EXIT_FAILURE;
+		}
+
+		CPUFeatures::setTier(tier);
+		argc--;
+		argv++;
+	}
+
+	// The scene is the same for every run.
+	Random random(0);
+	VoxelGrid voxelGrid(GRID_WIDTH, GRID_HEIGHT, GRID_DEPTH, 1.0);
+	fillVoxelGrid(voxelGrid, random, 0);
+
+	const std::string mode = (argc > 1) ? argv[1] : std::string();
+	if ((mode == "--golden-write") || (mode == "--golden-check"))
+	{
+		if (argc < 3)
+		{
+			std::fprintf(stderr, "Missing golden image directory.\n");
+			return EXIT_FAILURE;
+		}
+
+		const std::string directory = argv[2];
+		if (mode == "--golden-write")
+		{
+			return writeGoldenImages(voxelGrid, directory);
+		}
+		else
+		{
+			const int tolerance = (argc > 3) ? std::atoi(argv[3]) : 0;
+			return checkGoldenImages(voxelGrid, directory, tolerance);
+		}
+	}
+
+	if (mode == "--precision-check")
+	{
+		const int tolerance = (argc > 2) ? std::atoi(argv[2]) : 0;
+		return checkPrecision(voxelGrid, tolerance);
+	}
+
+	if (mode == "--reuse-check")
+	{
+		return checkFrameReuse(voxelGrid);
+	}
+
+	if (mode == "--voxel-edit-check")
+	{
+		return checkVoxelEdits();
+	}
+
+	// The remaining arguments come after the optional mode flag.
+	const bool tiled3D = mode == "--3d-tiled";
+	const bool full3D = (mode == "--3d") || tiled3D;
+	const bool paletted = mode == "--paletted";
+	const int argStart = (full3D || paletted) ? 2 : 1;
+	const int frameCount = (argc > argStart) ? std::atoi(argv[argStart]) : DEFAULT_FRAME_COUNT;
+	const std::vector<std::string> resolutions = split(
+		(argc > (argStart + 1)) ? argv[argStart + 1] : DEFAULT_RESOLUTIONS);
+	const std::vector<std::string> threadCounts = split(
+		(argc > (argStart + 2)) ? argv[argStart + 2] : DEFAULT_THREAD_COUNTS);
+
+	if (frameCount <= 0)
+	{
+		std::fprintf(stderr, "Frame count must be positive.\n");
+		return EXIT_FAILURE;
+	}
+
+	std::printf("%d frames per run, %d flats, view distance %.1f, %s ray casting, %s, "
+		"%s precision.\n", frameCount, FLAT_COUNT, VIEW_DISTANCE,
+		tiled3D ? "tiled 3D" : (full3D ? "3D" : (paletted ? "paletted 2.5D" : "2.5D")),
+		CPUFeatures::getTierName(CPUFeatures::getTier()),
+		SoftwareRenderer::getPrecisionName());
+	std::printf("%-12s %8s %10s %12s %10s %8s\n", "Resolution", "Threads",
+		"Min (ms)", "Median (ms)", "P99 (ms)", "Busy %");
+
+	for (const std::string &resolution : resolutions)
+	{
+		int width, height;
+		if ((std::sscanf(resolution.c_str(), "%dx%d", &width, &height) != 2) ||
+			(width <= 0) || (height <= 0))
+		{
+			std::fprintf(stderr, "Invalid resolution \"%s\".\n", resolution.c_str());
+			return EXIT_FAILURE;
+		}
+
+		for (const std::string &threadCountStr : threadCounts)
+		{
+			const int threadCount = std::atoi(threadCountStr.c_str());
+			if (threadCount < 0)
+			{
+				std::fprintf(stderr, "Invalid thread count \"%s\".\n", threadCountStr.c_str());
+				return EXIT_FAILURE;
+			}
+
+			const Result result = runBenchmark(voxelGrid, width, height,
+				threadCount, frameCount, full3D, tiled3D, paletted);
+			std::printf("%-12s %8s %10.2f %12.2f %10.2f %8.1f\n", resolution.c_str(),
+				(threadCount == 0) ? "auto" : threadCountStr.c_str(), result.minMs,
+				result.medianMs, result.p99Ms, result.busyPercent);
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Compares row-major and column-major texture layouts for the kind of sampling done
+// by the software renderer's 2.5D wall and flat loops: each screen column samples
+// one texture column from top to bottom, with the texture X coordinate fixed.
+
+// Usage: tesarena_texturebench [frames] [texture count]
+
+namespace
+{
+	const int TEXTURE_WIDTH = 64;
+	const int TEXTURE_HEIGHT = 64;
+
+	enum class Layout { RowMajor, ColumnMajor };
+
+	// Makes a set of textures with arbitrary texels in the given layout.
+	std::vector<std::vector<uint32_t>> makeTextures(int count, Layout layout)
+	{
+		std::vector<std::vector<uint32_t>> textures(count);
+		for (int i = 0; i < count; ++i)
+		{
+			std::vector<uint32_t> &texture = textures[i];
+			texture = std::vector<uint32_t>(TEXTURE_WIDTH * TEXTURE_HEIGHT);
+
+			for (int y = 0; y < TEXTURE_HEIGHT; ++y)
+			{
+				for (int x = 0; x < TEXTURE_WIDTH; ++x)
+				{
+					const uint32_t texel = static_cast<uint32_t>(
+						(i * 2654435761u) ^ (x * 40503u) ^ (y * 97u));
+					const int index = (layout == Layout::RowMajor) ?
+						(x + (y * TEXTURE_WIDTH)) : ((x * TEXTURE_HEIGHT) + y);
+					texture[index] = texel;
+				}
+			}
+		}
+
+		return textures;
+	}
+
+	// Draws one frame of textured columns. Walls are a few dozen columns wide and
+	// their projected heights vary across the screen like a street with near and
+	// far buildings. Returns a checksum so the work isn't optimized away.
+	template <Layout layout>
+	uint32_t drawFrame(std::vector<uint32_t> &frameBuffer, int width, int height,
+		const std::vector<std::vector<uint32_t>> &textures, int frame)
+	{
+		const int textureCount = static_cast<int>(textures.size());
+		const double widthReal = static_cast<double>(width);
+		uint32_t *pixels = frameBuffer.data();
+
+		for (int x = 0; x < width; ++x)
+		{
+			const double xPercent = static_cast<double>(x) / widthReal;
+
+			// Wall segments are ~1/24th of the screen wide.
+			const int segment = static_cast<int>(xPercent * 24.0);
+			const double u = (xPercent * 24.0) - static_cast<double>(segment);
+			const std::vector<uint32_t> &texture =
+				textures[(segment * 7 + frame) % textureCount];
+
+			// Distance from 0.5 to 24 voxels, so both magnified and minified columns
+			// are drawn.
+			const double distance = 0.50 + (23.5 * (0.50 + (0.50 * std::sin(
+				(xPercent * 9.0) + (static_cast<double>(frame) * 0.05)))));
+			const int projectedHeight = static_cast<int>(
+				static_cast<double>(height) / distance);
+			const int projectedStart = (height - projectedHeight) / 2;
+			const int projectedEnd = projectedStart + projectedHeight;
+			const int drawStart = std::max(0, projectedStart);
+			const int drawEnd = std::min(height, projectedEnd);
+
+			const int textureX = static_cast<int>(u * static_cast<double>(TEXTURE_WIDTH));
+			const uint32_t *texels = texture.data();
+
+			for (int y = drawStart; y < drawEnd; ++y)
+			{
+				const int textureY = ((y - projectedStart) * TEXTURE_HEIGHT) / projectedHeight;
+				const uint32_t texel = (layout == Layout::RowMajor) ?
+					texels[textureX + (textureY * TEXTURE_WIDTH)] :
+					texels[(textureX * TEXTURE_HEIGHT) + textureY];
+				pixels[x + (y * width)] = texel;
+			}
+		}
+
+		return pixels[(width / 2) + ((height / 2) * width)];
+	}
+
+	// Returns the average milliseconds per frame for a layout at a resolution.
+	template <Layout layout>
+	double runLayout(int width, int height, int frames, int textureCount, uint32_t &checksum)
+	{
+		const auto textures = makeTextures(textureCount, layout);
+		std::vector<uint32_t> frameBuffer(width * height);
+
+		// Warm up once so both layouts start with the same cache state.
+		checksum += drawFrame<layout>(frameBuffer, width, height, textures, 0);
+
+		const auto startTime = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			checksum += drawFrame<layout>(frameBuffer, width, height, textures, frame);
+		}
+
+		const std::chrono::duration<double, std::milli> totalTime =
+			std::chrono::steady_clock::now() - startTime;
+		return totalTime.count() / static_cast<double>(frames);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	const int frames = (argc > 1) ? std::atoi(argv[1]) : 100;
+	const int textureCount = (argc > 2) ? std::atoi(argv[2]) : 64;
+	if ((frames <= 0) || (textureCount <= 0))
+	{
+		std::fprintf(stderr, "Usage: %s [frames] [texture count]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	struct Resolution
+	{
+		const char *name;
+		int width, height;
+	};
+
+	const Resolution resolutions[] =
+	{
+		{ "1080p", 1920, 1080 },
+		{ "4K", 3840, 2160 }
+	};
+
+	std::printf("%d frames, %d textures of %dx%d\n", frames, textureCount,
+		TEXTURE_WIDTH, TEXTURE_HEIGHT);
+
+	uint32_t checksum = 0;
+	for (const Resolution &resolution : resolutions)
+	{
+		const double rowMajorMS = runLayout<Layout::RowMajor>(
+			resolution.width, resolution.height, frames, textureCount, checksum);
+		const double columnMajorMS = runLayout<Layout::ColumnMajor>(
+			resolution.width, resolution.height, frames, textureCount, checksum);
+
+		std::printf("%-6s row-major: %8.3f ms/frame  column-major: %8.3f ms/frame  (%.2fx)\n",
+			resolution.name, rowMajorMS, columnMajorMS, rowMajorMS / columnMajorMS);
+	}
+
+	// Print the checksum so the drawing can't be optimized out.
+	std::printf("Checksum: %08x\n", checksum);
+
+	return EXIT_SUCCESS;
+}